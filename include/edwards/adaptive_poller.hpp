@@ -0,0 +1,102 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_ADAPTIVE_POLLER_HPP
+#define EDWARDS_ADAPTIVE_POLLER_HPP
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <gsl/gsl>
+
+#include <edwards/error.hpp>
+#include <edwards/multidrop_endpoint.hpp>
+#include <edwards/multidrop_network.hpp>
+#include <edwards/nEXT.hpp>
+#include <edwards/units.hpp>
+
+namespace edwards {
+    struct poll_sample {
+        multidrop_endpoint        pump;
+        // Valid only when ec is clear
+        pump_speed_status         state;
+        error_code                ec;
+        // Time until the pump will next be polled
+        std::chrono::milliseconds next_period;
+    };
+
+    /// Polls the speed and status of a set of pumps, adjusting how often each pump is polled to
+    /// how quickly it is changing.
+    ///
+    /// A pump which is ramping (between stopped and normal speed), failed, or whose speed moved by
+    /// more than the speed threshold since its last sample, including its first sample, is polled
+    /// at the fastest period.  Otherwise its period doubles after every unchanged sample up to the slowest
+    /// period, so pumps sitting at normal speed or stopped cost little bus time.  Pumps which do
+    /// not answer back off the same way.
+    ///
+    /// Every member function must be called on the io thread of the network, and the poller must
+    /// not be destroyed while a poll is outstanding; stop it, which cancels the polls still queued
+    /// or in progress, and let the io_service run first.
+    class adaptive_poller {
+    public:
+        struct options {
+            std::chrono::milliseconds fastest = std::chrono::milliseconds{ 250 };
+            std::chrono::milliseconds slowest = std::chrono::seconds{ 10 };
+            // Smallest change in speed between samples regarded as the pump changing
+            hertz_t                   speed_threshold = hertz_t{ 5 };
+        };
+
+        using sample_handler = std::function<void(const poll_sample &)>;
+
+        adaptive_poller(multidrop_network & network, const options & opts, sample_handler on_sample);
+
+        adaptive_poller(const adaptive_poller &) = delete;
+        adaptive_poller & operator=(const adaptive_poller &) = delete;
+
+        /// Starts polling pump, immediately and then at the fastest period until it settles.
+        auto add(multidrop_endpoint pump) -> void;
+
+        auto remove(multidrop_endpoint pump) -> void;
+
+        auto start() -> void;
+        auto stop() -> void;
+
+        /// Current polling period of pump, or zero if it is not being polled.
+        auto period(multidrop_endpoint pump) const noexcept -> std::chrono::milliseconds;
+
+    private:
+        struct endpoint {
+            multidrop_endpoint                    pump;
+            std::chrono::milliseconds             period;
+            std::chrono::steady_clock::time_point next_due;
+            hertz_t                               last_speed{ 0 };
+            bool                                  has_sample = false;
+            bool                                  in_flight = false;
+        };
+
+        /// Polls every endpoint which is due and re-arms the timer for the next one.
+        auto on_tick() -> void;
+        auto schedule() -> void;
+        auto poll(endpoint & e) -> void;
+        auto on_sample(multidrop_endpoint pump, const result<pump_speed_status> & r) -> void;
+        auto next_period(const endpoint & e, const result<pump_speed_status> & r) const noexcept -> std::chrono::milliseconds;
+
+        auto find(multidrop_endpoint pump) noexcept -> endpoint *;
+
+        gsl::not_null<multidrop_network*> _network;
+        options                           _options;
+        sample_handler                    _on_sample;
+        boost::asio::steady_timer         _timer;
+        // Given to every poll, replaced each time it is cancelled by stop()
+        cancellation_source               _cancellation;
+        std::vector<endpoint>             _endpoints;
+        bool                              _running = false;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_ADAPTIVE_POLLER_HPP
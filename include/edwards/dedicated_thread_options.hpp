@@ -0,0 +1,29 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_DEDICATED_THREAD_OPTIONS_HPP
+#define EDWARDS_DEDICATED_THREAD_OPTIONS_HPP
+
+#include <chrono>
+#include <optional>
+
+namespace edwards {
+    /// Configures the thread a multidrop_network can be given to run its exchanges on, see
+    /// multidrop_network::run_on_dedicated_thread.
+    struct dedicated_thread_options {
+        // Core the thread is pinned to, or unpinned if empty
+        std::optional<int>        cpu;
+        // Runs the thread under SCHED_FIFO at this priority (1-99) if set.  Usually needs
+        // CAP_SYS_NICE or a suitable RLIMIT_RTPRIO.
+        std::optional<int>        fifo_priority;
+        // After writing a request the port is polled without sleeping for this long, then the
+        // thread waits in poll() for the rest of the response timeout.  Long enough to cover the
+        // usual turnaround keeps the reply off the scheduler's wake-up path, at the cost of a
+        // busy core while waiting.
+        std::chrono::microseconds spin = std::chrono::microseconds{ 0 };
+    };
+} // namespace edwards
+
+#endif // EDWARDS_DEDICATED_THREAD_OPTIONS_HPP
@@ -0,0 +1,81 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_FLEET_STATUS_HPP
+#define EDWARDS_FLEET_STATUS_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <edwards/nEXT.hpp>
+
+namespace edwards {
+    /// Condition on a status word.  A status matches if it has every flag in all_of, at least one
+    /// flag in any_of (unless any_of is empty) and no flag in none_of.
+    struct status_predicate {
+        nEXT_status all_of{ 0 };
+        nEXT_status any_of{ 0 };
+        nEXT_status none_of{ 0 };
+    };
+
+    /// Indices found by a single scan of a fleet_status.
+    struct fleet_scan {
+        // Pumps whose current status matches the predicate
+        std::vector<std::uint32_t> matches;
+        // Pumps which gained one of the watched flags since the previous snapshot
+        std::vector<std::uint32_t> raised;
+        // Pumps which lost one of the watched flags since the previous snapshot
+        std::vector<std::uint32_t> cleared;
+
+        auto clear() noexcept -> void {
+            matches.clear();
+            raised.clear();
+            cleared.clear();
+        }
+    };
+
+    /// Status words of every pump in a fleet, stored contiguously so a whole fleet can be
+    /// evaluated with SIMD instructions in one pass.
+    ///
+    /// Pumps are identified by a dense index chosen by the caller, typically assigned per
+    /// (network, endpoint) pair.  Alongside the current status a copy of the previous snapshot is
+    /// kept so transitions can be detected.
+    class fleet_status {
+    public:
+        explicit fleet_status(std::size_t size);
+
+        auto size() const noexcept -> std::size_t {
+            return _current.size();
+        }
+
+        auto set(std::size_t index, nEXT_status status) noexcept -> void {
+            assert(index < _current.size());
+            _current[index] = static_cast<std::uint32_t>(status);
+        }
+
+        auto get(std::size_t index) const noexcept -> nEXT_status {
+            assert(index < _current.size());
+            return static_cast<nEXT_status>(_current[index]);
+        }
+
+        /// Makes the current statuses the previous snapshot, call once per cycle after scanning.
+        auto advance() noexcept -> void;
+
+        /// Number of pumps whose current status matches predicate.
+        auto count(const status_predicate & predicate) const noexcept -> std::size_t;
+
+        /// Appends the indices of pumps matching predicate, and those which gained or lost any of
+        /// the watched flags since the previous snapshot, to result.
+        auto scan(const status_predicate & predicate, nEXT_status watched, fleet_scan & result) const -> void;
+
+    private:
+        std::vector<std::uint32_t> _current;
+        std::vector<std::uint32_t> _previous;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_FLEET_STATUS_HPP
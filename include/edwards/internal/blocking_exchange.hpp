@@ -0,0 +1,45 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_BLOCKING_EXCHANGE_HPP
+#define EDWARDS_INTERNAL_BLOCKING_EXCHANGE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include <edwards/error.hpp>
+#include <edwards/request_options.hpp>
+#include <edwards/internal/bus.hpp>
+#include <edwards/internal/dialog_primatives.hpp>
+
+namespace edwards::internal {
+    /// Writes message to the port open on fd and reads the response from the same device into
+    /// response, returning any error the device reports.  Polls the port without sleeping for spin
+    /// after writing, then waits in poll().  Gives up with timed_out at deadline, or with
+    /// operation_canceled once cancelled (if given) is set.  The caller must own the bus.
+    ///
+    /// When tracing is compiled in, write_end, first_byte and timeout are recorded against trace_id
+    /// unless it is 0.
+    auto exchange_on_port(int fd, const message_buffer & message, message_buffer & response,
+                          std::chrono::steady_clock::time_point deadline, std::chrono::microseconds spin,
+                          const std::atomic<bool> * cancelled, std::uint32_t trace_id) noexcept -> error_code;
+
+    /// Sends message and reads the response on the calling thread, without queuing a dialog or
+    /// needing the io_service to run.
+    ///
+    /// Waits for the bus to become idle, takes it directly and talks to the port through its native
+    /// handle with poll() bounding every wait.  Fails with timed_out if the bus cannot be taken by
+    /// the deadline (or within a few response timeouts if there is none) or the response is not
+    /// complete by the deadline (or response_timeout after writing), with operation_canceled if
+    /// cancelled before sending, or with the error the device reports.  Not retried.
+    ///
+    /// If the port fails, the bus is handed to the thread driving it to reopen the port, and
+    /// stays unavailable until it has.
+    auto exchange_blocking(bus & b, const message_buffer & message, message_buffer & response,
+                           const request_options & options) noexcept -> error_code;
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_BLOCKING_EXCHANGE_HPP
@@ -0,0 +1,184 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_BUS_HPP
+#define EDWARDS_INTERNAL_BUS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <edwards/dedicated_thread_options.hpp>
+#include <edwards/error.hpp>
+#include <edwards/retry_policy.hpp>
+#include <edwards/internal/mpsc_queue.hpp>
+
+namespace edwards::internal {
+    class dialog;
+
+    /// Owns the serial port of a multidrop network and hands it to one dialog at a time.
+    ///
+    /// Dialogs may be submitted from any thread.  They are queued in a lock-free MPSC queue and
+    /// started, in submission order, on a thread running the io_service once every earlier dialog
+    /// has released the port.  Whichever dialog currently owns the port is the only consumer of
+    /// the queue, so no lock is ever taken on the submission path.
+    ///
+    /// Background dialogs wait in a queue of their own which is only popped when the normal queue
+    /// is empty, so they fill slots the normal traffic leaves idle.  A normal dialog submitted
+    /// while a background one is exchanging messages waits for at most that one exchange.
+    ///
+    /// When an exchange fails with an error from the port itself, such as a USB adapter being reset,
+    /// the bus closes the port and reopens the device on a back-off schedule.  Until it succeeds
+    /// queued dialogs are held rather than failed; those with a deadline are completed with
+    /// timed_out once it passes, and cancelled ones are dropped.  The held dialogs are sent in
+    /// their original order once the port is back.
+    ///
+    /// Optionally the bus runs on a dedicated thread instead.  Dialogs are still queued the same
+    /// way, but whenever a submission finds the bus idle the dedicated thread is woken rather than
+    /// the io_service, and it exchanges each dialog synchronously on the port before moving on to
+    /// the next.  Awaiting coroutines are still resumed through the io_service, so only the
+    /// exchange itself moves off the io thread.  Port errors are recovered from on the dedicated
+    /// thread, which keeps the bus while it reopens the device.
+    ///
+    /// The bus also keeps the retry budget shared by every request made on it.
+    class bus {
+    public:
+        bus(boost::asio::io_service & service, std::string_view device);
+        ~bus();
+
+        bus(const bus &) = delete;
+        bus & operator=(const bus &) = delete;
+
+        auto get_io_service() noexcept -> boost::asio::io_service &;
+
+        auto port() noexcept -> boost::asio::serial_port &;
+
+        /// Queues the dialog for transmission.  Thread-safe.
+        auto submit(dialog & d) noexcept -> void;
+
+        /// Called by the active dialog, on the io thread, once it no longer needs the port.  Starts
+        /// the next queued dialog if there is one.
+        auto release() noexcept -> void;
+
+        /// Takes ownership of the port from any thread, without queuing, if the bus is idle and
+        /// connected.  Used for exchanges made synchronously on the calling thread.
+        auto try_acquire() noexcept -> bool;
+
+        /// Gives up ownership taken by try_acquire, reporting the outcome of the exchange made.
+        /// Dialogs queued meanwhile are started on the io (or dedicated) thread.
+        auto release_acquired(const error_code & ec = { }) noexcept -> void;
+
+        /// Moves the bus onto a thread of its own configured by options.  Must be called before any
+        /// requests are made.  Returns an error, and leaves the bus on the io_service, if the thread
+        /// can not be pinned or given the requested priority.
+        auto run_on_dedicated_thread(const dedicated_thread_options & options) -> error_code;
+
+        /// Called by the active dialog, on the io thread, with any error from a read or write.
+        /// Starts reconnecting if the error shows the port itself has failed.
+        auto report_error(const error_code & ec) noexcept -> void;
+
+        /// Replaces the retry policy.  Not thread-safe, must be called before any requests are made.
+        auto set_retry_policy(const retry_policy & policy) noexcept -> void;
+
+        /// Called whenever an exchange succeeds, earning part of a retry.  Thread-safe.
+        auto record_success() noexcept -> void;
+
+        /// Decides whether an exchange which failed with ec after attempts tries may be repeated.
+        /// Returns the time to back off for first, taking a retry from the budget, or nullopt if
+        /// the error is not transient, attempts are exhausted, the budget is spent or the back-off
+        /// would overrun the deadline.  Thread-safe.
+        auto plan_retry(const error_code & ec, int attempts,
+                        const std::optional<std::chrono::steady_clock::time_point> & deadline) noexcept
+            -> std::optional<std::chrono::steady_clock::duration>;
+
+    private:
+        /// Arranges for start_next to be run by whichever thread drives the bus.
+        auto dispatch_start_next() noexcept -> void;
+
+        /// Pops the next dialog and starts it.  Only called by the owner of the port.
+        auto start_next() noexcept -> void;
+
+        /// Body of the dedicated thread.
+        auto run_dedicated() noexcept -> void;
+
+        /// Exchanges every queued dialog on the dedicated thread until the bus is idle.
+        auto drain_dedicated() noexcept -> void;
+
+        /// Reopens the port on the dedicated thread, holding queued dialogs until it succeeds.
+        auto reconnect_dedicated() noexcept -> void;
+
+        /// Pops the next held dialog, else the next normal dialog, else a background one.
+        auto pop_next() noexcept -> dialog *;
+        auto pop_queued() noexcept -> dialog *;
+
+        auto open() noexcept -> error_code;
+
+        /// Takes ownership of the queue while the port is down, until reconnected.
+        auto park() noexcept -> void;
+
+        auto schedule_reconnect() noexcept -> void;
+        auto arm_reconnect_timer(std::chrono::steady_clock::time_point wake) noexcept -> void;
+        auto on_reconnect_timer() noexcept -> void;
+
+        /// Moves every queued dialog into _held and completes those which are stale.  Returns the
+        /// earliest deadline among those still held.
+        auto hold_queued() noexcept -> std::optional<std::chrono::steady_clock::time_point>;
+
+        std::string              _device;
+        boost::asio::serial_port _port;
+        mpsc_queue<dialog>       _queue;
+        mpsc_queue<dialog>       _background;
+        // Number of dialogs submitted to either queue but not yet released, including the active one.
+        std::atomic<std::size_t> _pending{ 0 };
+
+        // False while the port is closed waiting to be reopened.  Written by the owner of the bus,
+        // read by try_acquire from any thread.
+        std::atomic<bool>         _connected{ true };
+
+        // Reconnection state, only accessed on the io thread (_held by the dedicated thread instead
+        // when there is one)
+        boost::asio::steady_timer _reconnect_timer;
+        std::chrono::milliseconds _reconnect_backoff;
+        std::deque<dialog*>       _held;
+        // The bus, rather than a dialog, owns the queue until the port is reopened
+        bool                      _parked = false;
+        bool                      _reconnecting = false;
+        // Incremented whenever the reconnect timer is set, to ignore a superseded wait
+        std::uint64_t             _reconnect_generation = 0;
+
+        retry_policy              _retry_policy;
+        // Retries currently available, in thousandths of a retry
+        std::atomic<long>         _retry_tokens;
+
+        // Dedicated thread mode
+        std::thread               _thread;
+        std::mutex                _wake_mutex;
+        std::condition_variable   _wake;
+        bool                      _wake_pending = false;
+        // The bus was handed over still owned, by a synchronous exchange which broke the port.
+        // Accessed on the io thread, or under _wake_mutex when there is a dedicated thread.
+        bool                      _handed_over = false;
+        // A dialog was submitted while disconnected, for reconnect_dedicated to hold.  Kept apart
+        // from _wake_pending, which may only be set when the bus has been left idle.
+        bool                      _hold_pending = false;
+        bool                      _stopping = false;
+        std::atomic<bool>         _dedicated{ false };
+        std::chrono::microseconds _spin{ 0 };
+    };
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_BUS_HPP
@@ -0,0 +1,26 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_CANCELLATION_STATE_HPP
+#define EDWARDS_INTERNAL_CANCELLATION_STATE_HPP
+
+#include <atomic>
+
+#include <boost/asio/io_service.hpp>
+
+namespace edwards::internal {
+    class dialog;
+
+    /// State shared by copies of a cancellation_source and the dialogs using it.
+    struct cancellation_state {
+        std::atomic<bool>                     cancelled{ false };
+        // io_service of the dialogs using this state, set before they are queued
+        std::atomic<boost::asio::io_service*> service{ nullptr };
+        // Dialog currently exchanging messages, only accessed on the io thread
+        dialog *                              active = nullptr;
+    };
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_CANCELLATION_STATE_HPP
@@ -0,0 +1,43 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_DELAY_HPP
+#define EDWARDS_INTERNAL_DELAY_HPP
+
+#include <chrono>
+#include <experimental/coroutine>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <edwards/error.hpp>
+
+namespace edwards::internal {
+    /// Awaitable which resumes the awaiting coroutine on the io thread after a period of time.
+    class delay {
+    public:
+        delay(boost::asio::io_service & service, std::chrono::steady_clock::duration period)
+            : _timer{ service }
+            , _period{ period }
+        { }
+
+        auto await_ready() const noexcept -> bool {
+            return _period <= std::chrono::steady_clock::duration::zero();
+        }
+
+        auto await_suspend(std::experimental::coroutine_handle<> handle) -> void {
+            _timer.expires_from_now(_period);
+            _timer.async_wait([handle](const error_code &) { handle.resume(); });
+        }
+
+        auto await_resume() const noexcept -> void { }
+
+    private:
+        boost::asio::steady_timer           _timer;
+        std::chrono::steady_clock::duration _period;
+    };
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_DELAY_HPP
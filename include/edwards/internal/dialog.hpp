@@ -7,20 +7,34 @@
 #define EDWARDS_INTERNAL_DIALOG_HPP
 
 #include <array>
+#include <chrono>
 #include <experimental/coroutine>
+#include <memory>
+#include <optional>
+#include <string_view>
 
-#include <boost/asio/deadline_timer.hpp>
 #include <boost/asio/serial_port.hpp>
+#include <boost/asio/steady_timer.hpp>
 #include <gsl/gsl>
 #include <fmt/format.h>
 
 #include <edwards/error.hpp>
+#include <edwards/request_options.hpp>
+#include <edwards/internal/bus.hpp>
+#include <edwards/internal/cancellation_state.hpp>
 #include <edwards/internal/dialog_primatives.hpp>
+#include <edwards/internal/mpsc_queue.hpp>
+#include <edwards/internal/trace.hpp>
 
 namespace edwards::internal {
     struct dialog_result {
         message_buffer response;
+        // Either a communication error or the error reported by the device in its response
         error_code     ec;
+#if EDWARDS_ENABLE_TRACING
+        // Transaction the result came from, to attach later events such as a retry to it
+        std::uint32_t  trace_id = 0;
+#endif
     };
 
     constexpr auto view_message(const dialog_result & result) noexcept {
@@ -30,13 +44,53 @@ namespace edwards::internal {
     constexpr auto view_data(const dialog_result & result) noexcept {
         return view_data(result.response);
     }
-    
-    class dialog {
+
+    // Longest time a device may take to respond
+    static constexpr auto response_timeout = std::chrono::milliseconds{ 500 };
+
+    /// Extracts the error code a device reports in its response, if any.
+    auto check_response(std::string_view response) -> error_code;
+
+    /// Whether a command can safely be sent again when its outcome is unknown.
+    enum class idempotency {
+        // Queries and setters of absolute values, repeating them changes nothing
+        idempotent,
+        // Commands such as start/stop whose effect must be read back before they are repeated,
+        // retried by the caller rather than by the dialog
+        verify_first,
+        // Never repeated
+        never
+    };
+
+    /// Checks the data of an otherwise successful response, returning an error if it is malformed.
+    using response_validator = error_code (*)(std::string_view data);
+
+    /// How a dialog treats failures: which exchanges it repeats by itself and what it considers a
+    /// failure beyond the device reporting an error.
+    struct exchange_class {
+        idempotency        retry;
+        response_validator validate;
+    };
+
+    /// A single request/response exchange on a multidrop network.  Awaiting a dialog queues it on
+    /// the bus; the awaiting coroutine is resumed on the io thread once the response (or an error)
+    /// has been received, even when the exchange was made on the bus's dedicated thread.
+    ///
+    /// A dialog whose deadline passes or which is cancelled while queued is dropped without being
+    /// sent.  One which is already exchanging messages is abandoned by cancelling the outstanding
+    /// operations on the port, which while it owns the bus can only be its own.
+    ///
+    /// An idempotent dialog which fails transiently is repeated by the dialog itself, as permitted
+    /// by the bus's retry policy, before the awaiting coroutine is resumed.  While backing off it
+    /// does not hold the bus.
+    class dialog
+        : public mpsc_node
+    {
     public:
-        dialog(boost::asio::serial_port & port) noexcept;
+        dialog(bus & b, const request_options & options, const exchange_class & kind) noexcept;
         template<typename... Args>
-        dialog(boost::asio::serial_port & port, Args&&... args)
-            : dialog{ port }
+        dialog(bus & b, const request_options & options, const exchange_class & kind, Args&&... args)
+            : dialog{ b, options, kind }
         {
             format_message(std::forward<Args>(args)...);
         }
@@ -60,6 +114,33 @@ namespace edwards::internal {
         auto await_resume() noexcept -> dialog_result;
 
     private:
+        friend class bus;
+        friend class ::edwards::cancellation_source;
+
+        /// Called by the bus, on the io thread, once this dialog owns the serial port.  Returns
+        /// false if the dialog was dropped without using the port, in which case the port is still
+        /// owned by the bus.
+        auto start() noexcept -> bool;
+
+        /// Called by the bus on its dedicated thread, once this dialog owns the serial port.
+        /// Exchanges the message synchronously, polling the port without sleeping for spin after
+        /// writing, then schedules the dialog to be resumed or retried as signal_completion does.
+        /// Returns the error the exchange itself ended with, for the bus to notice port failures.
+        auto run_inline(std::chrono::microseconds spin) noexcept -> error_code;
+
+        /// Completes the dialog without sending it if it has been cancelled or its deadline has
+        /// passed, returning true if it did.  Called by the bus owner on the io thread.
+        auto drop_if_stale() noexcept -> bool;
+
+        auto is_background() const noexcept -> bool;
+
+        /// Schedules the awaiting coroutine to be resumed on the io thread.  The dialog may be
+        /// destroyed by the time this returns.
+        auto resume() noexcept -> void;
+
+        /// Cuts short an exchange in progress, called on the io thread when cancelled.
+        auto abandon() noexcept -> void;
+
         /// Executed when the asynchronous write operation is complete.  Will queue the
         /// following asynchronous read to get the response from the network device or
         /// resume continuation on error.
@@ -76,13 +157,36 @@ namespace edwards::internal {
 
         auto on_timeout(const error_code & ec) noexcept -> void;
 
-        auto complete(const error_code & code) -> void;
-
-        gsl::not_null<boost::asio::serial_port*> _port;
-        boost::asio::deadline_timer              _timer;
-        message_buffer                           _message;
-        dialog_result                            _result;
-        std::experimental::coroutine_handle<>    _resume_handle;
+        /// Releases the bus and schedules the awaiting coroutine to be resumed, or the dialog to
+        /// be sent again if it failed transiently and may be retried.
+        auto signal_completion(const error_code & code) -> void;
+
+        /// Records the outcome of an exchange.  Returns true if the dialog is finished and the
+        /// awaiting coroutine should be resumed, false if a retry has been scheduled instead.
+        auto complete(const error_code & code) -> bool;
+
+        /// Queues the dialog again after waiting for backoff.
+        auto retry_after(std::chrono::steady_clock::duration backoff) -> void;
+
+        gsl::not_null<bus*>                                  _bus;
+        boost::asio::steady_timer                            _timer;
+        message_buffer                                       _message;
+        dialog_result                                        _result;
+        std::experimental::coroutine_handle<>                _resume_handle;
+        std::optional<std::chrono::steady_clock::time_point> _deadline;
+        std::shared_ptr<cancellation_state>                  _cancellation;
+        exchange_class                                       _kind;
+        request_priority                                     _priority;
+        int                                                  _attempts;
+#if EDWARDS_ENABLE_TRACING
+        auto trace(trace_event event) const noexcept -> void;
+
+        std::uint32_t                                        _trace_id = 0;
+        bool                                                 _first_byte = false;
+#endif
+        // True from start() until signal_completion(), only accessed on the io thread
+        bool                                                 _active;
+        bool                                                 _abandoned;
     };
 } // namespace edwards::internal
 
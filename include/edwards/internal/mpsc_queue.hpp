@@ -0,0 +1,93 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_MPSC_QUEUE_HPP
+#define EDWARDS_INTERNAL_MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <type_traits>
+
+namespace edwards::internal {
+    /// Link embedded in every object which can be placed in an mpsc_queue.
+    struct mpsc_node {
+        std::atomic<mpsc_node*> next{ nullptr };
+    };
+
+    /// Intrusive, unbounded, lock-free multi-producer single-consumer queue.
+    ///
+    /// Any number of threads may push concurrently, but only one thread at a time may pop.  Pushing
+    /// is wait-free (a single exchange), popping is lock-free except for the short window in which a
+    /// producer has claimed the back of the queue but not yet linked its node; during that window
+    /// try_pop reports the queue as empty.  The queue never owns its nodes.
+    template<typename T>
+    class mpsc_queue {
+    public:
+        mpsc_queue() noexcept
+            : _back{ &_stub }
+            , _front{ &_stub }
+        { }
+
+        mpsc_queue(const mpsc_queue &) = delete;
+        mpsc_queue & operator=(const mpsc_queue &) = delete;
+
+        /// Appends node to the back of the queue.  Safe to call from any thread.
+        auto push(T & node) noexcept -> void {
+            // Checked here rather than at class scope so the queue can be declared while T is
+            // still incomplete
+            static_assert(std::is_base_of_v<mpsc_node, T>, "queued type must derive from mpsc_node");
+            push_node(&node);
+        }
+
+        /// Removes the node at the front of the queue, or returns nullptr if no node is (yet) visible.
+        /// Must only be called by the current consumer.
+        auto try_pop() noexcept -> T* {
+            auto front = _front;
+            auto next = front->next.load(std::memory_order_acquire);
+
+            if (front == &_stub) {
+                if (next == nullptr) {
+                    return nullptr;
+                }
+                // Skip over the stub node
+                _front = next;
+                front = next;
+                next = next->next.load(std::memory_order_acquire);
+            }
+
+            if (next != nullptr) {
+                _front = next;
+                return static_cast<T*>(front);
+            }
+
+            if (front != _back.load(std::memory_order_acquire)) {
+                // A producer is part way through a push
+                return nullptr;
+            }
+
+            // front is the last node in the queue, put the stub behind it so it can be detached
+            push_node(&_stub);
+
+            next = front->next.load(std::memory_order_acquire);
+            if (next != nullptr) {
+                _front = next;
+                return static_cast<T*>(front);
+            }
+            return nullptr;
+        }
+
+    private:
+        auto push_node(mpsc_node * node) noexcept -> void {
+            node->next.store(nullptr, std::memory_order_relaxed);
+            const auto prev = _back.exchange(node, std::memory_order_acq_rel);
+            prev->next.store(node, std::memory_order_release);
+        }
+
+        alignas(64) std::atomic<mpsc_node*> _back;
+        alignas(64) mpsc_node*              _front;
+        mpsc_node                           _stub;
+    };
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_MPSC_QUEUE_HPP
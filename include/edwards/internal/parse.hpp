@@ -0,0 +1,38 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_PARSE_HPP
+#define EDWARDS_INTERNAL_PARSE_HPP
+
+#include <string>
+#include <string_view>
+
+#include <edwards/error.hpp>
+#include <edwards/nEXT.hpp>
+#include <edwards/result.hpp>
+
+namespace edwards::internal {
+    // Parsers for the data of each query's response, as returned by view_data.  Malformed data
+    // fails with protocol_error, which makes the dialog repeat the query.
+
+    auto parse_pump_info(std::string_view data) -> result<pump_info>;
+
+    auto parse_speed_status(std::string_view data) -> result<pump_speed_status>;
+
+    auto parse_vent_mode(std::string_view data) -> result<vent_mode>;
+
+    /// Parses response data consisting of a single decimal integer.
+    auto parse_integer(std::string_view data) -> result<long>;
+
+    auto parse_temperature(std::string_view data) -> result<pump_temperature>;
+
+    auto parse_PIC_version(std::string_view data) -> result<std::string>;
+
+    auto parse_run_hours(std::string_view data) -> result<run_hours>;
+
+    auto parse_service_status(std::string_view data) -> result<service_status>;
+} // namespace edwards::internal
+
+#endif // EDWARDS_INTERNAL_PARSE_HPP
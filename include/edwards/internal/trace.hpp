@@ -0,0 +1,88 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_INTERNAL_TRACE_HPP
+#define EDWARDS_INTERNAL_TRACE_HPP
+
+#include <edwards/trace.hpp>
+
+#if EDWARDS_ENABLE_TRACING
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#else
+#   include <chrono>
+#endif
+
+namespace edwards::internal {
+    struct trace_record {
+        std::uint64_t          ticks;
+        std::uint32_t          dialog;
+        trace_event            event;
+        std::uint8_t           endpoint;
+        // Object of the message, e.g. "?V852", only recorded on enqueue
+        std::array<char, 6>    command;
+        // Operating system id of the thread which made the record, rings outlive their threads
+        std::uint32_t          thread;
+    };
+
+    /// Ring of the most recent trace records made by one thread.  Only the owning thread writes,
+    /// the exporter reads up to the published head.
+    struct trace_ring {
+        static constexpr std::size_t capacity = 1 << 14;
+
+        std::array<trace_record, capacity> records;
+        std::atomic<std::uint64_t>         head{ 0 };
+        // Id of the thread currently holding the ring
+        std::uint32_t                      thread = 0;
+    };
+
+    /// Ring of the calling thread, taken on first use from the exporter, which reuses it once the
+    /// thread exits.  Must not be used from the destructors of other thread_local objects.
+    auto this_thread_trace_ring() -> trace_ring &;
+
+    /// Allocates an id identifying a dialog across its trace records.
+    auto next_trace_id() noexcept -> std::uint32_t;
+
+    inline auto trace_ticks() noexcept -> std::uint64_t {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    inline auto record_trace(trace_event event, std::uint32_t dialog, int endpoint, const char * command = nullptr) noexcept -> void {
+        auto & ring = this_thread_trace_ring();
+
+        const auto head = ring.head.load(std::memory_order_relaxed);
+        auto & r = ring.records[head & (trace_ring::capacity - 1)];
+        r.ticks = trace_ticks();
+        r.dialog = dialog;
+        r.event = event;
+        r.endpoint = static_cast<std::uint8_t>(endpoint);
+        r.thread = ring.thread;
+        r.command = { };
+        if (command != nullptr) {
+            for (auto i = std::size_t{ 0 }; i < r.command.size() - 1 && command[i] != ' ' && command[i] != '\r'; ++i) {
+                r.command[i] = command[i];
+            }
+        }
+        ring.head.store(head + 1, std::memory_order_release);
+    }
+} // namespace edwards::internal
+
+#   define EDWARDS_TRACE(...) ::edwards::internal::record_trace(__VA_ARGS__)
+#else
+#   define EDWARDS_TRACE(...) ((void)0)
+#endif
+
+#endif // EDWARDS_INTERNAL_TRACE_HPP
@@ -0,0 +1,84 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_MAINTENANCE_COLLECTOR_HPP
+#define EDWARDS_MAINTENANCE_COLLECTOR_HPP
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+
+#include <gsl/gsl>
+
+#include <edwards/error.hpp>
+#include <edwards/multidrop_endpoint.hpp>
+#include <edwards/multidrop_network.hpp>
+#include <edwards/nEXT.hpp>
+
+namespace edwards {
+    /// Maintenance counters of a pump as last collected.  Each value is empty until it has been
+    /// read successfully at least once.  updated is when any value was last read successfully, and
+    /// ec holds the first error of the most recent collection, clear if every read in it succeeded.
+    struct maintenance_record {
+        std::optional<run_hours>              controller_run_time;
+        std::optional<run_hours>              pump_run_time;
+        std::optional<run_hours>              bearing_run_time;
+        std::optional<service_status>         service;
+        std::chrono::system_clock::time_point updated;
+        error_code                            ec;
+    };
+
+    /// Periodically reads the run time counters and service status of a set of pumps at
+    /// background priority, so the reads only take bus slots not wanted by other requests, and
+    /// caches the results.
+    ///
+    /// add, remove, start and stop must be called on the io thread of the network; record may be
+    /// called from any thread.  The collector must not be destroyed while a collection is
+    /// outstanding; stop it, which cancels the requests still queued or in progress, and let the
+    /// io_service run first.
+    class maintenance_collector {
+    public:
+        maintenance_collector(multidrop_network & network, std::chrono::steady_clock::duration interval);
+
+        maintenance_collector(const maintenance_collector &) = delete;
+        maintenance_collector & operator=(const maintenance_collector &) = delete;
+
+        auto add(multidrop_endpoint pump) -> void;
+        auto remove(multidrop_endpoint pump) -> void;
+
+        /// Collects from every pump now and then once per interval.
+        auto start() -> void;
+        /// Stops collecting, cancelling any collection in progress.  Its records are left as they
+        /// were before it started.
+        auto stop() -> void;
+
+        /// Latest counters collected from pump, or nullopt if it is not being collected.
+        auto record(multidrop_endpoint pump) const -> std::optional<maintenance_record>;
+
+    private:
+        struct entry {
+            multidrop_endpoint pump;
+            maintenance_record record;
+        };
+
+        auto collect() -> void;
+        auto collect_one(multidrop_endpoint pump) -> boost::future<void>;
+
+        gsl::not_null<multidrop_network*>   _network;
+        std::chrono::steady_clock::duration _interval;
+        boost::asio::steady_timer           _timer;
+        // Given to every request, replaced each time it is cancelled by stop()
+        cancellation_source                 _cancellation;
+        bool                                _running = false;
+        // Guards _entries, which is read by dashboards on other threads
+        mutable std::mutex                  _mutex;
+        std::vector<entry>                  _entries;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_MAINTENANCE_COLLECTOR_HPP
@@ -0,0 +1,41 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_MULTIDROP_ENDPOINT_HPP
+#define EDWARDS_MULTIDROP_ENDPOINT_HPP
+
+#include <cassert>
+
+namespace edwards {
+    class multidrop_endpoint {
+    public:
+        constexpr multidrop_endpoint(int i) noexcept
+            : _endpoint{ i }
+        {
+            assert(_endpoint >= 1 && _endpoint <= 99);
+        }
+
+        multidrop_endpoint(const multidrop_endpoint &) = default;
+        multidrop_endpoint(multidrop_endpoint &&) = default;
+
+        multidrop_endpoint & operator=(const multidrop_endpoint &) = default;
+        multidrop_endpoint & operator=(multidrop_endpoint &&) = default;
+
+        constexpr int get() const noexcept {
+            return _endpoint;
+        }
+
+        constexpr bool is_wildcard() const noexcept {
+            return _endpoint == 99;
+        }
+
+    private:
+        int _endpoint;
+    };
+
+    static constexpr auto endpoint_wildcard = multidrop_endpoint{ 99 };
+} // namespace edwards
+
+#endif // EDWARDS_MULTIDROP_ENDPOINT_HPP
@@ -6,145 +6,278 @@
 #ifndef EDWARDS_MULTIDROP_NETWORK_HPP
 #define EDWARDS_MULTIDROP_NETWORK_HPP
 
-#include <cassert>
+#include <atomic>
 #include <chrono>
-#include <mutex>
 #include <string>
 #include <string_view>
 #include <tuple>
+#include <utility>
 
 #include <boost/thread/future.hpp>
 
 #include <gsl/gsl>
 
 #include <edwards/config.hpp>
+#include <edwards/dedicated_thread_options.hpp>
 #include <edwards/error.hpp>
+#include <edwards/multidrop_endpoint.hpp>
 #include <edwards/nEXT.hpp>
+#include <edwards/request_options.hpp>
+#include <edwards/result.hpp>
+#include <edwards/retry_policy.hpp>
 #include <edwards/units.hpp>
+#include <edwards/internal/bus.hpp>
 #include <edwards/internal/dialog_primatives.hpp>
 
 namespace edwards {
+    class state_publisher;
+
     struct factory_default_t { };
 
     static constexpr auto factory_default = factory_default_t{};
 
-    class multidrop_endpoint {
-    public:
-        constexpr multidrop_endpoint(int i) noexcept
-            : _endpoint{ i }
-        {
-            assert(_endpoint >= 1 && _endpoint <= 99);
-        }
-
-        multidrop_endpoint(const multidrop_endpoint &) = default;
-        multidrop_endpoint(multidrop_endpoint &&) = default;
-
-        multidrop_endpoint & operator=(const multidrop_endpoint &) = default;
-        multidrop_endpoint & operator=(multidrop_endpoint &&) = default;
-
-        constexpr int get() const noexcept {
-            return _endpoint;
-        }
-
-        constexpr bool is_wildcard() const noexcept {
-            return _endpoint == 99;
-        }
-
-    private:
-        int _endpoint;
-    };
+    struct blocking_t { };
 
-    static constexpr auto endpoint_wildcard = multidrop_endpoint{ 99 };
+    /// Selects the synchronous overloads of multidrop_network, see there.
+    static constexpr auto blocking = blocking_t{};
 
+    /// Client for a network of Edwards devices sharing one RS485 port.
+    ///
+    /// All member functions may be called concurrently from any thread.  Requests are queued
+    /// without locking and sent one at a time, in the order they were made, by whichever thread
+    /// is running the io_service; the returned futures become ready on that thread.
+    ///
+    /// Every request comes in two forms.  The try_ form reports failure through the returned
+    /// result and never throws, which is the cheaper choice where failures are routine (e.g.
+    /// polling a pump which may be switched off).  The plain form holds system_error in the
+    /// returned future on failure, at no extra cost on success.  Both accept request_options to set
+    /// a deadline or attach a cancellation_source.
+    ///
+    /// The common requests also have blocking overloads, selected by passing blocking first, which
+    /// exchange the message on the calling thread and return the result directly.  They need no
+    /// thread to run the io_service, skip the coroutine and future machinery, and are meant for
+    /// short-lived tools and probes.  They wait for any asynchronous exchange in progress to
+    /// finish, are not retried and do not publish to the state_publisher.
+    ///
+    /// Requests failing because of noise on the bus are retried according to the retry_policy.
+    /// Start, stop and factory reset are only repeated once reading the pump back shows the
+    /// previous attempt was not carried out.
+    ///
+    /// Where turnaround must not depend on other work sharing the io_service, the network can be
+    /// given a thread of its own with run_on_dedicated_thread.  Exchanges are then made
+    /// synchronously on that thread, which sleeps while the bus is idle.  The returned futures
+    /// still become ready on the io thread, as without one, so continuations never run on (or
+    /// hold up) the bus thread.
     class multidrop_network {
     public:
         multidrop_network(EDWARDS_ASIO_NS::io_service & service, std::string_view rs485_port);
 
         auto get_io_service() noexcept -> EDWARDS_ASIO_NS::io_service &;
-        
+
+        /// Publishes every speed, status and temperature successfully read from a pump to publisher,
+        /// or stops publishing if publisher is null.  The publisher must outlive the network or be
+        /// detached first.
+        auto publish_to(state_publisher * publisher) noexcept -> void;
+
+        /// Replaces the default retry_policy.  Must be called before any requests are made.
+        auto set_retry_policy(const retry_policy & policy) noexcept -> void;
+
+        /// Exchanges messages on a thread owned by the network, optionally pinned to a core and
+        /// run under SCHED_FIFO, instead of the io_service.  Must be called before any requests are
+        /// made.  Fails, leaving the network as it was, if the thread cannot be configured as asked
+        /// (typically for lack of privilege), and with operation_not_supported on Windows.
+        auto run_on_dedicated_thread(const dedicated_thread_options & options) -> error_code;
+
         // 851
-        auto pump_info(multidrop_endpoint pump) -> boost::future<edwards::pump_info>;
-        auto pump_info(multidrop_endpoint pump, error_code & ec) -> boost::future<edwards::pump_info>;
+        auto try_pump_info(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<edwards::pump_info>>;
+        auto pump_info(multidrop_endpoint pump, request_options options = {}) -> boost::future<edwards::pump_info>;
 
         // 852
-        auto start_pump(multidrop_endpoint pump) -> boost::future<void>;
-        auto start_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
+        auto try_start_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<void>>;
+        auto start_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<void>;
 
-        auto stop_pump(multidrop_endpoint pump) -> boost::future<void>;
-        auto stop_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
-        
-        auto pump_current_speed(multidrop_endpoint pump) -> boost::future<hertz_t>;
-        auto pump_current_speed(multidrop_endpoint pump, error_code & ec) -> boost::future<hertz_t>;
+        auto try_stop_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<void>>;
+        auto stop_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<void>;
 
-        auto pump_status(multidrop_endpoint pump) -> boost::future<nEXT_status>;
-        auto pump_status(multidrop_endpoint pump, error_code & ec) -> boost::future<nEXT_status>;
+        auto try_pump_current_speed(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<hertz_t>>;
+        auto pump_current_speed(multidrop_endpoint pump, request_options options = {}) -> boost::future<hertz_t>;
+
+        auto try_pump_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<nEXT_status>>;
+        auto pump_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<nEXT_status>;
+
+        /// Reads speed and status in a single exchange.
+        auto try_pump_speed_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<edwards::pump_speed_status>>;
+        auto pump_speed_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<edwards::pump_speed_status>;
 
         // 853
-        auto pump_vent_mode(multidrop_endpoint pump) -> boost::future<vent_mode>;
-        auto pump_vent_mode(multidrop_endpoint pump, error_code & ec) -> boost::future<vent_mode>;
+        auto try_pump_vent_mode(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<vent_mode>>;
+        auto pump_vent_mode(multidrop_endpoint pump, request_options options = {}) -> boost::future<vent_mode>;
 
-        auto pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode) -> boost::future<void>;
-        auto pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, error_code & ec) -> boost::future<void>;
+        auto try_pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, request_options options = {}) -> boost::future<result<void>>;
+        auto pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, request_options options = {}) -> boost::future<void>;
 
-        auto pump_vent_mode(multidrop_endpoint pump, factory_default_t) -> boost::future<void> {
-            return pump_vent_mode(pump, vent_mode::_0);
+        auto try_pump_vent_mode(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<result<void>> {
+            return try_pump_vent_mode(pump, vent_mode::_0, std::move(options));
         }
-        auto pump_vent_mode(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
-            return pump_vent_mode(pump, vent_mode::_0, ec);
+        auto pump_vent_mode(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<void> {
+            return pump_vent_mode(pump, vent_mode::_0, std::move(options));
         }
 
         // 854
-        auto pump_timer(multidrop_endpoint pump) -> boost::future<std::chrono::minutes>;
-        auto pump_timer(multidrop_endpoint pump, error_code & ec) -> boost::future<std::chrono::minutes>;
-        auto pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout)->boost::future<void>;
-        auto pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, error_code & ec) -> boost::future<void>;
-        auto pump_timer(multidrop_endpoint pump, factory_default_t) -> boost::future<void> {
-            return pump_timer(pump, 8min);
+        auto try_pump_timer(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<std::chrono::minutes>>;
+        auto pump_timer(multidrop_endpoint pump, request_options options = {}) -> boost::future<std::chrono::minutes>;
+
+        auto try_pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options = {}) -> boost::future<result<void>>;
+        auto pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options = {}) -> boost::future<void>;
+
+        auto try_pump_timer(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<result<void>> {
+            return try_pump_timer(pump, 8min, std::move(options));
         }
-        auto pump_timer(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
-            return pump_timer(pump, 8min, ec);
+        auto pump_timer(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<void> {
+            return pump_timer(pump, 8min, std::move(options));
         }
- 
+
         // 855
-        auto pump_power_limit(multidrop_endpoint pump) -> boost::future<watt_t>;
-        auto pump_power_limit(multidrop_endpoint pump, error_code & ec) -> boost::future<watt_t>;
+        auto try_pump_power_limit(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<watt_t>>;
+        auto pump_power_limit(multidrop_endpoint pump, request_options options = {}) -> boost::future<watt_t>;
 
-        auto pump_power_limit(multidrop_endpoint pump, watt_t new_limit) -> boost::future<void>;
-        auto pump_power_limit(multidrop_endpoint pump, watt_t new_limit, error_code & ec) -> boost::future<void>;
+        auto try_pump_power_limit(multidrop_endpoint pump, watt_t new_limit, request_options options = {}) -> boost::future<result<void>>;
+        auto pump_power_limit(multidrop_endpoint pump, watt_t new_limit, request_options options = {}) -> boost::future<void>;
 
-        auto pump_power_limit(multidrop_endpoint pump, factory_default_t) -> boost::future<void> {
-            return pump_power_limit(pump, 160_W);
+        auto try_pump_power_limit(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<result<void>> {
+            return try_pump_power_limit(pump, 160_W, std::move(options));
         }
-        auto pump_power_limit(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
-            return pump_power_limit(pump, 160_W, ec);
+        auto pump_power_limit(multidrop_endpoint pump, factory_default_t, request_options options = {}) -> boost::future<void> {
+            return pump_power_limit(pump, 160_W, std::move(options));
         }
 
         // 859
-        auto pump_temp(multidrop_endpoint pump) -> boost::future<pump_temperature>;
-        auto pump_temp(multidrop_endpoint pump, error_code & ec) -> boost::future<pump_temperature>;
+        auto try_pump_temp(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<pump_temperature>>;
+        auto pump_temp(multidrop_endpoint pump, request_options options = {}) -> boost::future<pump_temperature>;
 
         // 867
-        auto factory_reset_pump(multidrop_endpoint pump) -> boost::future<void>;
-        auto factory_reset_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
-        
-        auto pump_PIC_version(multidrop_endpoint pump) -> boost::future<std::string>;
-        auto pump_PIC_version(multidrop_endpoint pump, error_code & ec) -> boost::future<std::string>;
+        auto try_factory_reset_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<void>>;
+        auto factory_reset_pump(multidrop_endpoint pump, request_options options = {}) -> boost::future<void>;
+
+        // 868
+        auto try_pump_PIC_version(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<std::string>>;
+        auto pump_PIC_version(multidrop_endpoint pump, request_options options = {}) -> boost::future<std::string>;
 
         // 875
-        auto close_vent_valve(multidrop_endpoint pump) -> boost::future<void>;
+        auto try_close_vent_valve(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<void>>;
+        auto close_vent_valve(multidrop_endpoint pump, request_options options = {}) -> boost::future<void>;
+
+        // Run times are reported by the pump as a pair of hour counts, returned in the order sent
+
+        // 882
+        auto try_controller_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<run_hours>>;
+        auto controller_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<run_hours>;
+
+        // 883
+        auto try_pump_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<run_hours>>;
+        auto pump_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<run_hours>;
+
+        // 885
+        auto try_bearing_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<run_hours>>;
+        auto bearing_run_time(multidrop_endpoint pump, request_options options = {}) -> boost::future<run_hours>;
+
+        // 886
+        auto try_pump_service_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<result<edwards::service_status>>;
+        auto pump_service_status(multidrop_endpoint pump, request_options options = {}) -> boost::future<edwards::service_status>;
+
+        // Error code forms, superseded by the try_ forms.  ec is written when the request completes
+        // so must outlive the returned future, which holds a default value on failure.
+
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_info(multidrop_endpoint pump, error_code & ec) -> boost::future<edwards::pump_info>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto start_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto stop_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_current_speed(multidrop_endpoint pump, error_code & ec) -> boost::future<hertz_t>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_status(multidrop_endpoint pump, error_code & ec) -> boost::future<nEXT_status>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_vent_mode(multidrop_endpoint pump, error_code & ec) -> boost::future<vent_mode>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_vent_mode(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_timer(multidrop_endpoint pump, error_code & ec) -> boost::future<std::chrono::minutes>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_timer(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_power_limit(multidrop_endpoint pump, error_code & ec) -> boost::future<watt_t>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_power_limit(multidrop_endpoint pump, watt_t new_limit, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_power_limit(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_temp(multidrop_endpoint pump, error_code & ec) -> boost::future<pump_temperature>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto factory_reset_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
+        auto pump_PIC_version(multidrop_endpoint pump, error_code & ec) -> boost::future<std::string>;
+        [[deprecated("use the try_ form, ec must outlive the returned future")]]
         auto close_vent_valve(multidrop_endpoint pump, error_code & ec) -> boost::future<void>;
 
-        //std::tuple<std::chrono::hours, std::chrono::hours> controller_run_time(multidrop_endpoint pump);
-        //std::tuple<std::chrono::hours, std::chrono::hours> pump_run_time(multidrop_endpoint pump);
-        //std::tuple<std::chrono::hours, std::chrono::hours> bearing_run_time(multidrop_endpoint pump);
+        // Blocking forms
+
+        auto try_pump_info(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<edwards::pump_info>;
+        auto try_start_pump(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<void>;
+        auto try_stop_pump(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<void>;
+        auto try_pump_speed_status(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<edwards::pump_speed_status>;
+        auto try_pump_vent_mode(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<vent_mode>;
+        auto try_pump_vent_mode(blocking_t, multidrop_endpoint pump, vent_mode new_mode, const request_options & options = {}) -> result<void>;
+        auto try_pump_timer(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<std::chrono::minutes>;
+        auto try_pump_timer(blocking_t, multidrop_endpoint pump, std::chrono::minutes new_timeout, const request_options & options = {}) -> result<void>;
+        auto try_pump_power_limit(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<watt_t>;
+        auto try_pump_power_limit(blocking_t, multidrop_endpoint pump, watt_t new_limit, const request_options & options = {}) -> result<void>;
+        auto try_pump_temp(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<pump_temperature>;
+        auto try_pump_service_status(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<edwards::service_status>;
+        auto try_close_vent_valve(blocking_t, multidrop_endpoint pump, const request_options & options = {}) -> result<void>;
 
     private:
-        template<typename... Args>
-        auto send_message(error_code & ec, Args&&... args) -> boost::future<void>;
-        template<typename... Args>
-        auto send_query(error_code & ec, Args&&... args) -> boost::future<internal::message_buffer>;
-        
-        EDWARDS_ASIO_NS::serial_port	_port;
+        // Each request is made by a single coroutine, which delivers its outcome as Out: result<T>
+        // for the try_ form, or T itself for the plain form, whose future then holds the error as
+        // system_error.
+        template<typename Out> auto pump_info_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_current_speed_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_speed_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_vent_mode_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_vent_mode_as(multidrop_endpoint pump, vent_mode new_mode, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_timer_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_timer_as(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_power_limit_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_power_limit_as(multidrop_endpoint pump, watt_t new_limit, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_temp_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto pump_PIC_version_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto close_vent_valve_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+        template<typename Out> auto run_time_as(multidrop_endpoint pump, request_options options, const char * command) -> boost::future<Out>;
+        template<typename Out> auto pump_service_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out>;
+
+        using verifier = auto (multidrop_network::*)(multidrop_endpoint, request_options) -> boost::future<result<bool>>;
+
+        /// Sends a command which may not be blindly repeated.  After a transient failure the pump
+        /// is checked with applied, and the command is only sent again if it had no effect.  Fails
+        /// with the error from applied if the pump cannot be read back.
+        template<typename Out>
+        auto send_verified(multidrop_endpoint pump, request_options options, const char * command,
+                           verifier applied) -> boost::future<Out>;
+
+        auto is_started(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>>;
+        auto is_stopped(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>>;
+        auto is_factory_default(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>>;
+
+        auto publish_status(multidrop_endpoint pump, hertz_t speed, nEXT_status status) noexcept -> void;
+
+        internal::bus                 _bus;
+        std::atomic<state_publisher*> _publisher{ nullptr };
     };
 } // namespace edwards
 
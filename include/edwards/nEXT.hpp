@@ -6,8 +6,10 @@
 #ifndef EDWARDS_NEXT_HPP
 #define EDWARDS_NEXT_HPP
 
+#include <chrono>
 #include <cstdint>
 #include <string>
+#include <tuple>
 #include <type_traits>
 
 #include <edwards/units.hpp>
@@ -61,6 +63,11 @@ namespace edwards {
         return (static_cast<U>(status) & static_cast<U>(flag)) == static_cast<U>(flag);
     }
 
+    constexpr nEXT_status operator|(nEXT_status lhs, nEXT_status rhs) noexcept {
+        using U = std::underlying_type_t<nEXT_status>;
+        return static_cast<nEXT_status>(static_cast<U>(lhs) | static_cast<U>(rhs));
+    }
+
     enum class vent_mode {
         // Hard vent when below 50% full speed for either stop command or fail condition. (Factory default).
         _0,
@@ -95,10 +102,18 @@ namespace edwards {
         celsius_t controller;
     };
 
+    // Object 852 reports the speed and the status word together
+    struct pump_speed_status {
+        hertz_t     speed;
+        nEXT_status status;
+    };
+
     enum class pump_speed {
         full,
         standby
     };
+
+    using run_hours = std::tuple<std::chrono::hours, std::chrono::hours>;
 } // namespace edwards
 
 #endif // EDWARDS_NEXT_HPP
\ No newline at end of file
@@ -0,0 +1,142 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_RECONCILER_HPP
+#define EDWARDS_RECONCILER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include <boost/asio/steady_timer.hpp>
+#include <boost/thread/future.hpp>
+
+#include <gsl/gsl>
+
+#include <edwards/error.hpp>
+#include <edwards/multidrop_network.hpp>
+#include <edwards/nEXT.hpp>
+#include <edwards/units.hpp>
+
+namespace edwards {
+    /// Desired configuration of a single pump.  Settings left empty are not managed.
+    struct pump_settings {
+        std::optional<vent_mode>            vent;
+        std::optional<std::chrono::minutes> timer;
+        std::optional<watt_t>               power_limit;
+    };
+
+    enum class pump_setting {
+        // Object 853
+        vent_mode,
+        // Object 854
+        timer,
+        // Object 855
+        power_limit
+    };
+
+    enum class reconcile_status {
+        // The pump did not match its target and has been written and verified
+        written,
+        // The pump does not match its target and has not been written
+        drifted,
+        // The setting could not be read, written or verified, see ec
+        failed,
+        // The pump acknowledged the write but reads back a different value, ec is not set
+        not_applied
+    };
+
+    struct setting_change {
+        multidrop_endpoint pump;
+        pump_setting       setting;
+        reconcile_status   status;
+        error_code         ec;
+    };
+
+    struct reconcile_report {
+        // Every managed setting which did not already match its target
+        std::vector<setting_change> changes;
+        // Number of managed settings which already matched their target
+        std::size_t                 in_sync = 0;
+    };
+
+    /// Brings the settings of the pumps on a network to a declared target state.
+    ///
+    /// Current values are read with every query queued at once, so the bus sends them back to back
+    /// rather than waiting for a round trip per pump, and only the settings which differ from the
+    /// target are written.
+    ///
+    /// Drift is only looked for when asked, either once by check_drift or periodically between
+    /// start_drift_checks and stop_drift_checks.  Every member must be called on the io thread of
+    /// the network.  The reconciler must not be destroyed while a periodic check is outstanding;
+    /// stop them, which cancels the requests still queued or in progress, and let the io_service
+    /// run first.
+    class configuration_reconciler {
+    public:
+        /// Called with the report of each periodic check which found a setting that does not
+        /// match its target or could not be read.
+        using drift_handler = std::function<void(const reconcile_report &)>;
+
+        explicit configuration_reconciler(multidrop_network & network);
+
+        configuration_reconciler(const configuration_reconciler &) = delete;
+        configuration_reconciler & operator=(const configuration_reconciler &) = delete;
+
+        /// Sets (or replaces) the target settings of pump.
+        auto set_target(multidrop_endpoint pump, const pump_settings & settings) -> void;
+
+        /// Stops managing the settings of pump.
+        auto clear_target(multidrop_endpoint pump) -> void;
+
+        /// Reads every managed setting, writes those which differ from their target and then
+        /// reads them back to verify the write took effect.
+        auto apply() -> boost::future<reconcile_report>;
+
+        /// Reads every managed setting and reports those which differ from their target without
+        /// writing anything.
+        auto check_drift(request_options options = {}) -> boost::future<reconcile_report>;
+
+        /// Checks for drift now and then once per interval, at background priority, passing
+        /// on_drift the report of every check which finds any.  Calling it again while running
+        /// replaces the interval and handler from the next check.
+        auto start_drift_checks(std::chrono::steady_clock::duration interval, drift_handler on_drift) -> void;
+        /// Stops checking for drift, cancelling any check in progress without reporting it.
+        auto stop_drift_checks() -> void;
+
+    private:
+        struct target {
+            multidrop_endpoint pump;
+            pump_settings      settings;
+        };
+
+        struct observed {
+            vent_mode            vent{ vent_mode::_0 };
+            error_code           vent_ec;
+            std::chrono::minutes timer{ 0 };
+            error_code           timer_ec;
+            watt_t               power_limit{ 0 };
+            error_code           power_limit_ec;
+        };
+
+        /// Reads the managed settings of every target, queuing all the queries before waiting
+        /// on any of them.
+        auto read(std::vector<target> targets, request_options options = {}) -> boost::future<std::vector<observed>>;
+
+        auto periodic_check() -> boost::future<void>;
+
+        gsl::not_null<multidrop_network*>   _network;
+        std::vector<target>                 _targets;
+        std::chrono::steady_clock::duration _drift_interval{ 0 };
+        drift_handler                       _on_drift;
+        boost::asio::steady_timer           _timer;
+        // Given to every periodic check, replaced each time it is cancelled by stop_drift_checks()
+        cancellation_source                 _cancellation;
+        bool                                _checking = false;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_RECONCILER_HPP
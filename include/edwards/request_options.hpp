@@ -0,0 +1,59 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_REQUEST_OPTIONS_HPP
+#define EDWARDS_REQUEST_OPTIONS_HPP
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+namespace edwards {
+    namespace internal {
+        struct cancellation_state;
+        class dialog;
+    }
+
+    /// Handle used to abandon one or more requests made on the same network.
+    ///
+    /// Copies share the same state, so one copy can be passed with the requests while another is
+    /// kept to cancel them.  Cancelling is thread-safe; requests still queued fail with
+    /// operation_canceled without being sent, and an exchange in progress is cut short.
+    class cancellation_source {
+    public:
+        cancellation_source();
+
+        auto cancel() noexcept -> void;
+        auto is_cancelled() const noexcept -> bool;
+
+    private:
+        friend class internal::dialog;
+
+        std::shared_ptr<internal::cancellation_state> _state;
+    };
+
+    enum class request_priority {
+        normal,
+        // Only sent when no normal request is waiting for the bus.  For housekeeping queries which
+        // must not delay control traffic.
+        background
+    };
+
+    /// Per-request options accepted by every multidrop_network request.
+    struct request_options {
+        // A request still queued at its deadline is dropped without being sent and fails with
+        // timed_out, an exchange in progress at its deadline is abandoned.
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        std::optional<cancellation_source>                   cancellation;
+        request_priority                                     priority = request_priority::normal;
+    };
+
+    /// Options for a request which must complete within timeout of being made.
+    inline auto within(std::chrono::steady_clock::duration timeout) -> request_options {
+        return request_options{ std::chrono::steady_clock::now() + timeout, std::nullopt, request_priority::normal };
+    }
+} // namespace edwards
+
+#endif // EDWARDS_REQUEST_OPTIONS_HPP
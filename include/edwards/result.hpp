@@ -0,0 +1,137 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_RESULT_HPP
+#define EDWARDS_RESULT_HPP
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include <edwards/config.hpp>
+#include <edwards/error.hpp>
+
+namespace edwards {
+    /// Either the value produced by a request or the error_code it failed with.  Checking a
+    /// result never throws, value() throws system_error if there is no value.
+    template<typename T>
+    class result {
+    public:
+        using value_type = T;
+
+        result(const T & value)
+            : _storage{ std::in_place_index<0>, value }
+        { }
+
+        result(T && value)
+            : _storage{ std::in_place_index<0>, std::move(value) }
+        { }
+
+        result(const error_code & ec)
+            : _storage{ std::in_place_index<1>, ec }
+        {
+            assert(ec);
+        }
+
+        auto has_value() const noexcept -> bool {
+            return _storage.index() == 0;
+        }
+
+        explicit operator bool() const noexcept {
+            return has_value();
+        }
+
+        auto value() & -> T & {
+            throw_if_error();
+            return *std::get_if<0>(&_storage);
+        }
+
+        auto value() const & -> const T & {
+            throw_if_error();
+            return *std::get_if<0>(&_storage);
+        }
+
+        auto value() && -> T {
+            throw_if_error();
+            return std::move(*std::get_if<0>(&_storage));
+        }
+
+        template<typename U>
+        auto value_or(U && fallback) const & -> T {
+            return has_value() ? **this : static_cast<T>(std::forward<U>(fallback));
+        }
+
+        auto operator*() & noexcept -> T & {
+            assert(has_value());
+            return *std::get_if<0>(&_storage);
+        }
+
+        auto operator*() const & noexcept -> const T & {
+            assert(has_value());
+            return *std::get_if<0>(&_storage);
+        }
+
+        auto operator->() noexcept -> T * {
+            return &**this;
+        }
+
+        auto operator->() const noexcept -> const T * {
+            return &**this;
+        }
+
+        /// The error the request failed with, or a default constructed (success) error_code.
+        auto error() const noexcept -> error_code {
+            if (const auto ec = std::get_if<1>(&_storage)) {
+                return *ec;
+            }
+            return {};
+        }
+
+    private:
+        auto throw_if_error() const -> void {
+            if (const auto ec = std::get_if<1>(&_storage)) {
+                throw EDWARDS_ERROR_NS::system_error{ *ec };
+            }
+        }
+
+        std::variant<T, error_code> _storage;
+    };
+
+    template<>
+    class result<void> {
+    public:
+        using value_type = void;
+
+        result() noexcept = default;
+
+        result(const error_code & ec) noexcept
+            : _ec{ ec }
+        { }
+
+        auto has_value() const noexcept -> bool {
+            return !_ec;
+        }
+
+        explicit operator bool() const noexcept {
+            return has_value();
+        }
+
+        auto value() const -> void {
+            if (_ec) {
+                throw EDWARDS_ERROR_NS::system_error{ _ec };
+            }
+        }
+
+        auto error() const noexcept -> error_code {
+            return _ec;
+        }
+
+    private:
+        error_code _ec;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_RESULT_HPP
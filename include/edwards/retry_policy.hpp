@@ -0,0 +1,33 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_RETRY_POLICY_HPP
+#define EDWARDS_RETRY_POLICY_HPP
+
+#include <chrono>
+
+namespace edwards {
+    /// Controls how a multidrop_network repeats requests which fail because of transient noise on
+    /// the bus (timeouts, garbled or mis-checksummed replies).
+    ///
+    /// Queries and setters of absolute values are simply repeated.  Commands whose repetition
+    /// could have a different effect (start/stop, factory reset) are only repeated after reading
+    /// back the pump's state shows the first attempt did not take effect.  Errors reported by the
+    /// pump itself are never retried.
+    struct retry_policy {
+        // Attempts made per request including the first, 1 disables retrying
+        int                       max_attempts = 3;
+        // Each retry waits a random time up to base_backoff * 2^(retry - 1), capped at max_backoff
+        std::chrono::milliseconds base_backoff = std::chrono::milliseconds{ 20 };
+        std::chrono::milliseconds max_backoff = std::chrono::milliseconds{ 250 };
+        // Every successful exchange earns budget_ratio of a retry, every retry spends one.  This
+        // bounds retries to a fraction of the normal traffic so they can not starve it.
+        double                    budget_ratio = 0.1;
+        // Most retries which can be saved up while the bus is healthy
+        double                    budget_cap = 10.0;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_RETRY_POLICY_HPP
@@ -0,0 +1,77 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_SHARED_STATE_HPP
+#define EDWARDS_SHARED_STATE_HPP
+
+#include <chrono>
+#include <optional>
+#include <string_view>
+
+#include <edwards/multidrop_endpoint.hpp>
+#include <edwards/nEXT.hpp>
+#include <edwards/units.hpp>
+
+namespace edwards {
+    namespace internal {
+        struct state_table;
+    }
+
+    /// Latest known state of a pump as read from shared memory.  Each group of values carries the
+    /// time it was last updated, which is the epoch if it has never been published.
+    struct pump_snapshot {
+        hertz_t                               speed;
+        nEXT_status                           status;
+        std::chrono::system_clock::time_point status_time;
+        pump_temperature                      temperature;
+        std::chrono::system_clock::time_point temperature_time;
+    };
+
+    /// Publishes the latest state of every pump on a network into a POSIX shared-memory segment.
+    ///
+    /// Each pump has its own slot guarded by a sequence lock, so updating never waits on readers
+    /// and readers never make a system call or take a lock.  There must be at most one publisher
+    /// per segment.  Updates to a given pump may be made from several threads; they take turns.
+    ///
+    /// Only available on POSIX systems, elsewhere constructing one throws operation_not_supported.
+    class state_publisher {
+    public:
+        /// Creates (or reuses) the shared memory object called name, e.g. "/edwards-bus0".
+        explicit state_publisher(std::string_view name);
+        ~state_publisher();
+
+        state_publisher(const state_publisher &) = delete;
+        state_publisher & operator=(const state_publisher &) = delete;
+
+        auto publish_status(multidrop_endpoint pump, hertz_t speed, nEXT_status status) noexcept -> void;
+        auto publish_temperature(multidrop_endpoint pump, const pump_temperature & temperature) noexcept -> void;
+
+        /// Removes the shared memory object called name.  Existing mappings stay valid.
+        static auto remove(std::string_view name) noexcept -> void;
+
+    private:
+        internal::state_table * _table;
+    };
+
+    /// Read-only view of a segment written by a state_publisher, usually in another process.
+    class state_reader {
+    public:
+        explicit state_reader(std::string_view name);
+        ~state_reader();
+
+        state_reader(const state_reader &) = delete;
+        state_reader & operator=(const state_reader &) = delete;
+
+        /// Takes a consistent snapshot of the state of pump, or returns nullopt if nothing has been
+        /// published for it yet or no consistent snapshot could be taken, e.g. because the
+        /// publisher died part way through an update.
+        auto read(multidrop_endpoint pump) const noexcept -> std::optional<pump_snapshot>;
+
+    private:
+        const internal::state_table * _table;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_SHARED_STATE_HPP
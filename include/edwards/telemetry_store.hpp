@@ -0,0 +1,174 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_TELEMETRY_STORE_HPP
+#define EDWARDS_TELEMETRY_STORE_HPP
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <edwards/multidrop_endpoint.hpp>
+#include <edwards/nEXT.hpp>
+#include <edwards/units.hpp>
+
+namespace edwards {
+    /// A single poll of a pump, stored in the integer units the pump reports.
+    struct telemetry_sample {
+        std::chrono::system_clock::time_point time;
+        // Hz
+        std::uint32_t                         speed;
+        nEXT_status                           status;
+        // Degrees celsius
+        std::int16_t                          motor_temperature;
+        std::int16_t                          controller_temperature;
+    };
+
+    auto make_telemetry_sample(std::chrono::system_clock::time_point time,
+                               hertz_t speed,
+                               nEXT_status status,
+                               const pump_temperature & temperature) noexcept -> telemetry_sample;
+
+    /// A run of samples for one pump, stored column by column.
+    struct telemetry_series {
+        std::vector<std::chrono::system_clock::time_point> time;
+        std::vector<std::uint32_t>                         speed;
+        std::vector<nEXT_status>                           status;
+        std::vector<std::int16_t>                          motor_temperature;
+        std::vector<std::int16_t>                          controller_temperature;
+
+        auto size() const noexcept -> std::size_t {
+            return time.size();
+        }
+    };
+
+    /// Summary of the samples falling in one downsampling interval.
+    struct telemetry_bucket {
+        std::chrono::system_clock::time_point start;
+        std::uint32_t                         count;
+        std::uint32_t                         min_speed;
+        std::uint32_t                         max_speed;
+        double                                mean_speed;
+        // Every status flag seen during the interval
+        nEXT_status                           any_status;
+        std::int16_t                          max_motor_temperature;
+        std::int16_t                          max_controller_temperature;
+    };
+
+    namespace internal {
+        class telemetry_segment;
+    }
+
+    /// Compressed in-memory history of the telemetry polled from a network.
+    ///
+    /// Samples for each pump are collected in a small column-oriented head chunk.  Once the chunk
+    /// is full every column is compressed on its own (delta-of-delta timestamps, delta speeds and
+    /// temperatures, XOR'd status words, with runs of zeros collapsed) into a block which is
+    /// appended to a fixed-size memory-mapped segment.  Steady-state pumps compress to well under
+    /// a byte per sample.
+    ///
+    /// Segments backed by files in a directory persist.  A store opened on a directory takes the
+    /// history left there by an earlier one, and leaves its own, including samples not yet
+    /// compressed, when destroyed.  Only the store holding the directory's lock file may use it;
+    /// another fails to construct.  Segments dropped because of max_segments are deleted.
+    ///
+    /// The store is not thread-safe.
+    class telemetry_store {
+    public:
+        struct options {
+            // Timestamps are rounded to this resolution before being stored
+            std::chrono::milliseconds resolution = std::chrono::seconds{ 1 };
+            // Size of each memory-mapped segment
+            std::size_t               segment_size = 16 * 1024 * 1024;
+            // Oldest segment is dropped once this many exist, 0 for no limit
+            std::size_t               max_segments = 0;
+            // Directory to back segments with files, anonymous memory if empty
+            std::string               directory;
+        };
+
+        telemetry_store();
+        explicit telemetry_store(options opts);
+        ~telemetry_store();
+
+        telemetry_store(const telemetry_store &) = delete;
+        telemetry_store & operator=(const telemetry_store &) = delete;
+
+        /// Appends a sample for pump.  Samples for a pump must be appended in time order.
+        auto append(multidrop_endpoint pump, const telemetry_sample & sample) -> void;
+
+        /// Returns every sample for pump with from <= time < to.
+        auto query(multidrop_endpoint pump,
+                   std::chrono::system_clock::time_point from,
+                   std::chrono::system_clock::time_point to) const -> telemetry_series;
+
+        /// Summarises the samples for pump with from <= time < to in intervals of width interval.
+        /// Intervals with no samples are omitted.
+        auto downsample(multidrop_endpoint pump,
+                        std::chrono::system_clock::time_point from,
+                        std::chrono::system_clock::time_point to,
+                        std::chrono::milliseconds interval) const -> std::vector<telemetry_bucket>;
+
+        /// Total bytes of compressed data held in segments.
+        auto compressed_size() const noexcept -> std::size_t;
+
+    private:
+        // Number of samples collected before a head chunk is compressed
+        static constexpr std::size_t chunk_capacity = 512;
+
+        struct chunk {
+            std::array<std::int64_t, chunk_capacity>  time;
+            std::array<std::uint32_t, chunk_capacity> speed;
+            std::array<std::uint32_t, chunk_capacity> status;
+            std::array<std::int16_t, chunk_capacity>  motor_temperature;
+            std::array<std::int16_t, chunk_capacity>  controller_temperature;
+            std::size_t                               size = 0;
+        };
+
+        struct block_ref {
+            std::uint64_t segment;
+            std::size_t   offset;
+            std::int64_t  first_time;
+            std::int64_t  last_time;
+        };
+
+        struct history {
+            std::unique_ptr<chunk> head;
+            std::deque<block_ref>  blocks;
+        };
+
+        auto lock_directory() -> void;
+        /// Reopens the segments in the directory and rebuilds the block index from them.
+        auto recover() -> void;
+
+        auto seal(history & h) -> void;
+        auto allocate(std::size_t bytes) -> block_ref;
+        auto drop_oldest_segment() -> void;
+        auto segment_data(std::uint64_t id) const noexcept -> const unsigned char *;
+
+        /// Calls f(chunk) for every block and head chunk of pump which may hold samples in range.
+        template<typename F>
+        auto for_each_chunk(multidrop_endpoint pump, std::int64_t from, std::int64_t to, F && f) const -> void;
+
+        auto to_ticks(std::chrono::system_clock::time_point time) const noexcept -> std::int64_t;
+        auto from_ticks(std::int64_t ticks) const noexcept -> std::chrono::system_clock::time_point;
+
+        options                                                  _options;
+        std::array<history, 100>                                 _histories;
+        std::deque<std::unique_ptr<internal::telemetry_segment>> _segments;
+        // Id of _segments.front()
+        std::uint64_t                                            _first_segment = 0;
+        std::size_t                                              _compressed_size = 0;
+        std::vector<unsigned char>                               _scratch;
+        // Descriptor holding the lock on the directory, if file-backed
+        int                                                      _lock = -1;
+    };
+} // namespace edwards
+
+#endif // EDWARDS_TELEMETRY_STORE_HPP
@@ -0,0 +1,47 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_TRACE_HPP
+#define EDWARDS_TRACE_HPP
+
+#include <cstdint>
+#include <ostream>
+
+// Tracing of bus transactions is compiled in when EDWARDS_ENABLE_TRACING is defined to 1, which
+// the EDWARDS_ENABLE_TRACING CMake option does.  Otherwise every trace point compiles to nothing
+// and the exporter writes an empty trace.
+#if !defined(EDWARDS_ENABLE_TRACING)
+#   define EDWARDS_ENABLE_TRACING 0
+#endif
+
+namespace edwards {
+    enum class trace_event : std::uint8_t {
+        // Dialog queued on the bus
+        enqueue,
+        // Dialog took the bus and began writing its message
+        write_start,
+        write_end,
+        first_byte,
+        // Response received, or the exchange failed for any reason other than a timeout
+        complete,
+        timeout,
+        // A failed exchange is being repeated
+        retry
+    };
+
+    /// Writes every recorded trace event in the Chrome trace event JSON format, which can be opened
+    /// in chrome://tracing or Perfetto.  Each dialog appears as an async slice from enqueue to
+    /// completion with the other events marked on it.
+    ///
+    /// Events are recorded into a fixed size ring buffer per thread, so only the most recent events
+    /// of each thread are kept.  Exporting while other threads are recording may tear the few
+    /// events being written at that moment.
+    auto export_chrome_trace(std::ostream & out) -> void;
+
+    /// Discards every recorded trace event.  Must not race with recording.
+    auto clear_trace() noexcept -> void;
+} // namespace edwards
+
+#endif // EDWARDS_TRACE_HPP
@@ -0,0 +1,158 @@
+#include <edwards/adaptive_poller.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include <common/coroutines.hpp>
+
+namespace edwards {
+    namespace {
+        /// True while the pump is in a state where its speed or status is expected to change.  The
+        /// vent valve is not such a state, it stays open on a stopped pump indefinitely; venting a
+        /// running pump shows as it slowing down.
+        auto is_transitioning(nEXT_status status) noexcept -> bool {
+            if (has_flag(status, nEXT_status::fail)) {
+                return true;
+            }
+            // Neither at normal speed nor stopped, so accelerating or decelerating
+            return !has_flag(status, nEXT_status::normal_speed) && !has_flag(status, nEXT_status::stopped_speed);
+        }
+    }
+
+    adaptive_poller::adaptive_poller(multidrop_network & network, const options & opts, sample_handler on_sample)
+        : _network{ &network }
+        , _options{ opts }
+        , _on_sample{ std::move(on_sample) }
+        , _timer{ network.get_io_service() }
+    {
+        assert(opts.fastest.count() > 0 && opts.fastest <= opts.slowest);
+    }
+
+    auto adaptive_poller::add(multidrop_endpoint pump) -> void {
+        if (find(pump) != nullptr) {
+            return;
+        }
+        _endpoints.push_back(endpoint{ pump, _options.fastest, std::chrono::steady_clock::now() });
+        schedule();
+    }
+
+    auto adaptive_poller::remove(multidrop_endpoint pump) -> void {
+        // A poll in flight reports back by endpoint number, so it is simply ignored once removed
+        _endpoints.erase(std::remove_if(_endpoints.begin(), _endpoints.end(),
+                                        [&](const endpoint & e) { return e.pump.get() == pump.get(); }),
+                         _endpoints.end());
+    }
+
+    auto adaptive_poller::start() -> void {
+        _running = true;
+        schedule();
+    }
+
+    auto adaptive_poller::stop() -> void {
+        _running = false;
+        _timer.cancel();
+        _cancellation.cancel();
+        _cancellation = cancellation_source{ };
+    }
+
+    auto adaptive_poller::period(multidrop_endpoint pump) const noexcept -> std::chrono::milliseconds {
+        const auto it = std::find_if(_endpoints.begin(), _endpoints.end(),
+                                     [&](const endpoint & e) { return e.pump.get() == pump.get(); });
+        return it == _endpoints.end() ? std::chrono::milliseconds{ 0 } : it->period;
+    }
+
+    auto adaptive_poller::find(multidrop_endpoint pump) noexcept -> endpoint * {
+        const auto it = std::find_if(_endpoints.begin(), _endpoints.end(),
+                                     [&](const endpoint & e) { return e.pump.get() == pump.get(); });
+        return it == _endpoints.end() ? nullptr : &*it;
+    }
+
+    auto adaptive_poller::schedule() -> void {
+        if (!_running) {
+            return;
+        }
+
+        auto earliest = std::chrono::steady_clock::time_point::max();
+        for (const auto & e : _endpoints) {
+            if (!e.in_flight) {
+                earliest = std::min(earliest, e.next_due);
+            }
+        }
+        if (earliest == std::chrono::steady_clock::time_point::max()) {
+            // Nothing to wait for, the next completed poll or add() re-arms the timer
+            return;
+        }
+
+        _timer.expires_at(earliest);
+        _timer.async_wait([this](const error_code & ec) {
+            if (!ec) {
+                on_tick();
+            }
+        });
+    }
+
+    auto adaptive_poller::on_tick() -> void {
+        const auto now = std::chrono::steady_clock::now();
+        for (auto & e : _endpoints) {
+            if (!e.in_flight && e.next_due <= now) {
+                poll(e);
+            }
+        }
+        schedule();
+    }
+
+    auto adaptive_poller::poll(endpoint & e) -> void {
+        e.in_flight = true;
+
+        // A sample older than the slowest period is no use, don't let it sit in the queue longer
+        auto options = within(_options.slowest);
+        options.cancellation = _cancellation;
+        [](adaptive_poller * self, multidrop_endpoint pump, request_options options) -> boost::future<void> {
+            const auto r = co_await self->_network->try_pump_speed_status(pump, std::move(options));
+            self->on_sample(pump, r);
+        }(this, e.pump, std::move(options));
+    }
+
+    auto adaptive_poller::on_sample(multidrop_endpoint pump, const result<pump_speed_status> & r) -> void {
+        const auto e = find(pump);
+        if (e == nullptr) {
+            return;
+        }
+
+        e->in_flight = false;
+        if (r.error() == boost::system::errc::operation_canceled) {
+            // Cut short by stop(), the pump is due again as soon as the poller is restarted
+            schedule();
+            return;
+        }
+        e->period = next_period(*e, r);
+        e->next_due = std::chrono::steady_clock::now() + e->period;
+        if (r) {
+            e->last_speed = r->speed;
+            e->has_sample = true;
+        }
+
+        if (_on_sample) {
+            _on_sample(poll_sample{ pump, r ? *r : pump_speed_status{ }, r.error(), e->period });
+        }
+        schedule();
+    }
+
+    auto adaptive_poller::next_period(const endpoint & e, const result<pump_speed_status> & r) const noexcept
+        -> std::chrono::milliseconds
+    {
+        const auto slower = std::min(e.period * 2, _options.slowest);
+        if (!r) {
+            return slower;
+        }
+
+        const auto speed_changed = !e.has_sample ||
+            std::abs(units::unit_cast<double>(r->speed - e.last_speed)) >= units::unit_cast<double>(_options.speed_threshold);
+        if (speed_changed || is_transitioning(r->status)) {
+            return _options.fastest;
+        }
+        return slower;
+    }
+} // namespace edwards
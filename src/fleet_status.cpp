@@ -0,0 +1,222 @@
+#include <edwards/fleet_status.hpp>
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <emmintrin.h>
+#   define EDWARDS_FLEET_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace edwards {
+    namespace {
+        using word = std::uint32_t;
+
+        /// Predicate and watched mask expanded into the form used by the kernels.
+        struct masks {
+            word all_of;
+            word any_of;
+            // All ones when any_of is empty, so the any_of test always passes
+            word any_bypass;
+            word none_of;
+            word watched;
+        };
+
+        auto make_masks(const status_predicate & predicate, nEXT_status watched) noexcept -> masks {
+            const auto any_of = static_cast<word>(predicate.any_of);
+            return masks{
+                static_cast<word>(predicate.all_of),
+                any_of,
+                any_of == 0 ? ~word{ 0 } : word{ 0 },
+                static_cast<word>(predicate.none_of),
+                static_cast<word>(watched)
+            };
+        }
+
+        inline auto matches(word status, const masks & m) noexcept -> bool {
+            return (status & m.all_of) == m.all_of &&
+                   ((status & m.any_of) != 0 || m.any_bypass != 0) &&
+                   (status & m.none_of) == 0;
+        }
+
+        inline auto count_trailing_zeros(unsigned bits) noexcept -> unsigned {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            return index;
+#else
+            return static_cast<unsigned>(__builtin_ctz(bits));
+#endif
+        }
+
+        /// Appends base + the position of every set bit in bits to out.
+        inline auto push_indices(unsigned bits, std::size_t base, std::vector<std::uint32_t> & out) -> void {
+            while (bits != 0) {
+                out.push_back(static_cast<std::uint32_t>(base + count_trailing_zeros(bits)));
+                bits &= bits - 1;
+            }
+        }
+
+        auto scan_scalar(const word * current, const word * previous, std::size_t begin, std::size_t end,
+                         const masks & m, fleet_scan & result) -> void {
+            for (auto i = begin; i < end; ++i) {
+                if (matches(current[i], m)) {
+                    result.matches.push_back(static_cast<std::uint32_t>(i));
+                }
+                const auto changed = (current[i] ^ previous[i]) & m.watched;
+                if (changed & current[i]) {
+                    result.raised.push_back(static_cast<std::uint32_t>(i));
+                }
+                if (changed & previous[i]) {
+                    result.cleared.push_back(static_cast<std::uint32_t>(i));
+                }
+            }
+        }
+
+#if defined(__AVX2__)
+        constexpr auto lanes = std::size_t{ 8 };
+
+        struct vector_masks {
+            __m256i all_of, any_of, any_bypass, none_of, watched, zero;
+
+            explicit vector_masks(const masks & m) noexcept
+                : all_of{ _mm256_set1_epi32(static_cast<int>(m.all_of)) }
+                , any_of{ _mm256_set1_epi32(static_cast<int>(m.any_of)) }
+                , any_bypass{ _mm256_set1_epi32(static_cast<int>(m.any_bypass)) }
+                , none_of{ _mm256_set1_epi32(static_cast<int>(m.none_of)) }
+                , watched{ _mm256_set1_epi32(static_cast<int>(m.watched)) }
+                , zero{ _mm256_setzero_si256() }
+            { }
+        };
+
+        inline auto bits(__m256i lanes_mask) noexcept -> unsigned {
+            return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(lanes_mask)));
+        }
+
+        /// Returns a bit per lane which is set where status matches the predicate.
+        inline auto match_bits(__m256i status, const vector_masks & v) noexcept -> unsigned {
+            const auto all_ok = _mm256_cmpeq_epi32(_mm256_and_si256(status, v.all_of), v.all_of);
+            const auto any_missing = _mm256_cmpeq_epi32(_mm256_and_si256(status, v.any_of), v.zero);
+            const auto any_ok = _mm256_or_si256(_mm256_andnot_si256(any_missing, _mm256_set1_epi32(-1)), v.any_bypass);
+            const auto none_ok = _mm256_cmpeq_epi32(_mm256_and_si256(status, v.none_of), v.zero);
+            return bits(_mm256_and_si256(all_ok, _mm256_and_si256(any_ok, none_ok)));
+        }
+
+        /// Returns a bit per lane which is set where value is non-zero.
+        inline auto nonzero_bits(__m256i value, const vector_masks & v) noexcept -> unsigned {
+            return ~bits(_mm256_cmpeq_epi32(value, v.zero)) & 0xffu;
+        }
+
+        inline auto load(const word * p) noexcept -> __m256i {
+            return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        }
+#elif defined(EDWARDS_FLEET_SSE2)
+        constexpr auto lanes = std::size_t{ 4 };
+
+        struct vector_masks {
+            __m128i all_of, any_of, any_bypass, none_of, watched, zero;
+
+            explicit vector_masks(const masks & m) noexcept
+                : all_of{ _mm_set1_epi32(static_cast<int>(m.all_of)) }
+                , any_of{ _mm_set1_epi32(static_cast<int>(m.any_of)) }
+                , any_bypass{ _mm_set1_epi32(static_cast<int>(m.any_bypass)) }
+                , none_of{ _mm_set1_epi32(static_cast<int>(m.none_of)) }
+                , watched{ _mm_set1_epi32(static_cast<int>(m.watched)) }
+                , zero{ _mm_setzero_si128() }
+            { }
+        };
+
+        inline auto bits(__m128i lanes_mask) noexcept -> unsigned {
+            return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(lanes_mask)));
+        }
+
+        inline auto match_bits(__m128i status, const vector_masks & v) noexcept -> unsigned {
+            const auto all_ok = _mm_cmpeq_epi32(_mm_and_si128(status, v.all_of), v.all_of);
+            const auto any_missing = _mm_cmpeq_epi32(_mm_and_si128(status, v.any_of), v.zero);
+            const auto any_ok = _mm_or_si128(_mm_andnot_si128(any_missing, _mm_set1_epi32(-1)), v.any_bypass);
+            const auto none_ok = _mm_cmpeq_epi32(_mm_and_si128(status, v.none_of), v.zero);
+            return bits(_mm_and_si128(all_ok, _mm_and_si128(any_ok, none_ok)));
+        }
+
+        inline auto nonzero_bits(__m128i value, const vector_masks & v) noexcept -> unsigned {
+            return ~bits(_mm_cmpeq_epi32(value, v.zero)) & 0xfu;
+        }
+
+        inline auto load(const word * p) noexcept -> __m128i {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        }
+#endif
+
+#if defined(__AVX2__) || defined(EDWARDS_FLEET_SSE2)
+#   define EDWARDS_FLEET_SIMD
+        // The AVX2 and SSE2 kernels only differ in width, spell out the few operations the scan
+        // needs on top of the helpers above.
+#   if defined(__AVX2__)
+        inline auto bit_and(__m256i a, __m256i b) noexcept { return _mm256_and_si256(a, b); }
+        inline auto bit_xor(__m256i a, __m256i b) noexcept { return _mm256_xor_si256(a, b); }
+#   else
+        inline auto bit_and(__m128i a, __m128i b) noexcept { return _mm_and_si128(a, b); }
+        inline auto bit_xor(__m128i a, __m128i b) noexcept { return _mm_xor_si128(a, b); }
+#   endif
+#endif
+    }
+
+    fleet_status::fleet_status(std::size_t size)
+        : _current(size, 0)
+        , _previous(size, 0)
+    { }
+
+    auto fleet_status::advance() noexcept -> void {
+        std::copy(_current.begin(), _current.end(), _previous.begin());
+    }
+
+    auto fleet_status::count(const status_predicate & predicate) const noexcept -> std::size_t {
+        const auto m = make_masks(predicate, nEXT_status{ 0 });
+        const auto n = _current.size();
+        auto total = std::size_t{ 0 };
+        auto i = std::size_t{ 0 };
+
+#if defined(EDWARDS_FLEET_SIMD)
+        const auto v = vector_masks{ m };
+        for (; i + lanes <= n; i += lanes) {
+            auto b = match_bits(load(&_current[i]), v);
+            while (b != 0) {
+                ++total;
+                b &= b - 1;
+            }
+        }
+#endif
+        for (; i < n; ++i) {
+            total += matches(_current[i], m) ? 1 : 0;
+        }
+        return total;
+    }
+
+    auto fleet_status::scan(const status_predicate & predicate, nEXT_status watched, fleet_scan & result) const -> void {
+        const auto m = make_masks(predicate, watched);
+        const auto n = _current.size();
+        auto i = std::size_t{ 0 };
+
+#if defined(EDWARDS_FLEET_SIMD)
+        const auto v = vector_masks{ m };
+        for (; i + lanes <= n; i += lanes) {
+            const auto current = load(&_current[i]);
+            const auto previous = load(&_previous[i]);
+
+            push_indices(match_bits(current, v), i, result.matches);
+
+            const auto changed = bit_and(bit_xor(current, previous), v.watched);
+            if (const auto changed_bits = nonzero_bits(changed, v); changed_bits != 0) {
+                push_indices(nonzero_bits(bit_and(changed, current), v), i, result.raised);
+                push_indices(nonzero_bits(bit_and(changed, previous), v), i, result.cleared);
+            }
+        }
+#endif
+        scan_scalar(_current.data(), _previous.data(), i, n, m, result);
+    }
+} // namespace edwards
@@ -0,0 +1,231 @@
+#include <edwards/internal/blocking_exchange.hpp>
+#include <edwards/internal/cancellation_state.hpp>
+#include <edwards/internal/dialog.hpp>
+#include <edwards/internal/trace.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <thread>
+
+#include <boost/asio/error.hpp>
+
+#if !defined(_WIN32)
+#   include <poll.h>
+#   include <unistd.h>
+#endif
+
+namespace edwards::internal {
+#if !defined(_WIN32)
+    namespace {
+        using std::chrono::steady_clock;
+
+        // Longest a request without a deadline waits for the bus, which asynchronous traffic may
+        // keep busy indefinitely
+        constexpr auto acquire_timeout = 4 * response_timeout;
+
+        auto last_error() noexcept -> error_code {
+            return { errno, boost::system::system_category() };
+        }
+
+        /// Waits for events on fd until deadline.  Returns timed_out if the deadline passes first,
+        /// or operation_canceled if cancelled is set while waiting.  Until spin_until the
+        /// descriptor is polled without sleeping.
+        auto wait_for(int fd, short events, steady_clock::time_point deadline,
+                      steady_clock::time_point spin_until = { },
+                      const std::atomic<bool> * cancelled = nullptr) noexcept -> error_code {
+            // Busy-polling keeps the thread on the CPU so the reply is seen as soon as it lands,
+            // instead of when the scheduler next wakes the thread
+            while (steady_clock::now() < std::min(spin_until, deadline)) {
+                auto p = pollfd{ fd, events, 0 };
+                if (::poll(&p, 1, 0) > 0) {
+                    return (p.revents & (POLLERR | POLLNVAL)) ? make_error_code(boost::system::errc::io_error) : error_code{ };
+                }
+                if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                    return make_error_code(boost::system::errc::operation_canceled);
+                }
+            }
+
+            // While cancellable, wake periodically to notice it
+            constexpr auto cancel_check = std::chrono::milliseconds{ 10 };
+            for (;;) {
+                if (cancelled && cancelled->load(std::memory_order_relaxed)) {
+                    return make_error_code(boost::system::errc::operation_canceled);
+                }
+                const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - steady_clock::now());
+                if (remaining.count() <= 0) {
+                    return boost::asio::error::timed_out;
+                }
+
+                auto p = pollfd{ fd, events, 0 };
+                const auto timeout = cancelled ? std::min(remaining, cancel_check) : remaining;
+                const auto n = ::poll(&p, 1, static_cast<int>(timeout.count()));
+                if (n > 0) {
+                    if (p.revents & (POLLERR | POLLNVAL)) {
+                        return make_error_code(boost::system::errc::io_error);
+                    }
+                    return { };
+                }
+                if (n < 0 && errno != EINTR) {
+                    return last_error();
+                }
+            }
+        }
+
+        auto write_all(int fd, std::string_view data, steady_clock::time_point deadline) noexcept -> error_code {
+            while (!data.empty()) {
+                const auto n = ::write(fd, data.data(), data.size());
+                if (n >= 0) {
+                    data.remove_prefix(static_cast<std::size_t>(n));
+                }
+                else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    // asio may have put the descriptor in non-blocking mode
+                    if (const auto ec = wait_for(fd, POLLOUT, deadline)) {
+                        return ec;
+                    }
+                }
+                else if (errno != EINTR) {
+                    return last_error();
+                }
+            }
+            return { };
+        }
+
+        /// Reads until a complete response from the device which was sent message is in response.
+        auto read_response(int fd, const message_buffer & message, message_buffer & response,
+                           steady_clock::time_point deadline, steady_clock::time_point spin_until,
+                           const std::atomic<bool> * cancelled, std::uint32_t trace_id) noexcept -> error_code {
+            auto read = std::size_t{ 0 };
+#if EDWARDS_ENABLE_TRACING
+            auto first_byte = trace_id == 0;
+#else
+            (void)trace_id;
+#endif
+            for (;;) {
+                // Frame what has already been read before waiting for more, our reply may have
+                // arrived in the same read as a message from someone else
+                const auto end = std::find(response.begin(), response.begin() + read, '\r');
+                if (end != response.begin() + read) {
+                    if (end - response.begin() >= 3 && response[1] == message[1] && response[2] == message[2]) {
+                        // Keep only our reply, which view_message frames by its last '\r'
+                        std::fill(end + 1, response.end(), '\0');
+                        return { };
+                    }
+
+                    // A message from someone else on the network, drop it and keep what follows
+                    const auto rest = std::copy(end + 1, response.begin() + read, response.begin());
+                    std::fill(rest, response.end(), '\0');
+                    read = static_cast<std::size_t>(rest - response.begin());
+                    continue;
+                }
+                if (read == response.size()) {
+                    return make_error_code(boost::system::errc::protocol_error);
+                }
+
+                if (const auto ec = wait_for(fd, POLLIN, deadline, spin_until, cancelled)) {
+                    return ec;
+                }
+
+                const auto n = ::read(fd, response.data() + read, response.size() - read);
+                if (n == 0) {
+                    return boost::asio::error::eof;
+                }
+                if (n < 0) {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                        continue;
+                    }
+                    return last_error();
+                }
+#if EDWARDS_ENABLE_TRACING
+                if (!first_byte) {
+                    first_byte = true;
+                    record_trace(trace_event::first_byte, trace_id, (message[1] - '0') * 10 + (message[2] - '0'));
+                }
+#endif
+                read += static_cast<std::size_t>(n);
+            }
+        }
+    }
+
+    auto exchange_on_port(int fd, const message_buffer & message, message_buffer & response,
+                          steady_clock::time_point deadline, std::chrono::microseconds spin,
+                          const std::atomic<bool> * cancelled, std::uint32_t trace_id) noexcept -> error_code {
+        response.fill('\0');
+        auto ec = write_all(fd, view_message(message), deadline);
+        if (!ec) {
+#if EDWARDS_ENABLE_TRACING
+            if (trace_id != 0) {
+                record_trace(trace_event::write_end, trace_id, (message[1] - '0') * 10 + (message[2] - '0'));
+            }
+#endif
+            ec = read_response(fd, message, response, deadline, steady_clock::now() + spin, cancelled, trace_id);
+        }
+        if (ec) {
+#if EDWARDS_ENABLE_TRACING
+            if (trace_id != 0 && ec == boost::asio::error::timed_out) {
+                record_trace(trace_event::timeout, trace_id, (message[1] - '0') * 10 + (message[2] - '0'));
+            }
+#endif
+            return ec;
+        }
+        const auto reply = view_message(response);
+        return reply.size() < 12 ? make_error_code(boost::system::errc::protocol_error) : check_response(reply);
+    }
+
+    auto exchange_blocking(bus & b, const message_buffer & message, message_buffer & response,
+                           const request_options & options) noexcept -> error_code {
+        const auto is_cancelled = [&] {
+            return options.cancellation && options.cancellation->is_cancelled();
+        };
+
+        // Spin briefly, then yield, then sleep while another exchange holds the bus
+        const auto give_up = options.deadline.value_or(steady_clock::now() + acquire_timeout);
+        for (auto spins = 0; !b.try_acquire(); ++spins) {
+            if (is_cancelled()) {
+                return make_error_code(boost::system::errc::operation_canceled);
+            }
+            if (give_up <= steady_clock::now()) {
+                return boost::asio::error::timed_out;
+            }
+            if (spins > 1024) {
+                std::this_thread::sleep_for(std::chrono::microseconds{ 200 });
+            }
+            else if (spins > 64) {
+                std::this_thread::yield();
+            }
+        }
+
+        auto ec = error_code{ };
+        if (is_cancelled()) {
+            ec = make_error_code(boost::system::errc::operation_canceled);
+        }
+        else {
+            const auto fd = b.port().native_handle();
+            const auto deadline = std::min(options.deadline.value_or(steady_clock::time_point::max()),
+                                           steady_clock::now() + response_timeout);
+
+            auto trace_id = std::uint32_t{ 0 };
+#if EDWARDS_ENABLE_TRACING
+            trace_id = next_trace_id();
+            const auto endpoint = (message[1] - '0') * 10 + (message[2] - '0');
+            record_trace(trace_event::enqueue, trace_id, endpoint, &message[6]);
+            record_trace(trace_event::write_start, trace_id, endpoint);
+#endif
+            ec = exchange_on_port(fd, message, response, deadline, std::chrono::microseconds{ 0 }, nullptr, trace_id);
+            EDWARDS_TRACE(trace_event::complete, trace_id, endpoint);
+        }
+
+        b.release_acquired(ec);
+        return ec;
+    }
+#else
+    auto exchange_on_port(int, const message_buffer &, message_buffer &, std::chrono::steady_clock::time_point,
+                          std::chrono::microseconds, const std::atomic<bool> *, std::uint32_t) noexcept -> error_code {
+        return make_error_code(boost::system::errc::operation_not_supported);
+    }
+
+    auto exchange_blocking(bus &, const message_buffer &, message_buffer &, const request_options &) noexcept -> error_code {
+        return make_error_code(boost::system::errc::operation_not_supported);
+    }
+#endif
+} // namespace edwards::internal
@@ -0,0 +1,509 @@
+#include <edwards/internal/bus.hpp>
+#include <edwards/internal/dialog.hpp>
+
+#include <algorithm>
+#include <future>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <boost/asio/error.hpp>
+
+#if !defined(_WIN32)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+namespace edwards::internal {
+    namespace {
+        constexpr auto token_scale = 1000.0;
+
+        constexpr auto first_reconnect_backoff = std::chrono::milliseconds{ 20 };
+        constexpr auto max_reconnect_backoff = std::chrono::milliseconds{ 500 };
+
+        /// True for errors which mean the port itself is unusable, e.g. the adapter was unplugged
+        /// or reset, rather than a single exchange having failed.  errno values are compared as
+        /// conditions, the port reports them in the system category.
+        auto is_port_error(const error_code & ec) noexcept -> bool {
+            return ec == boost::asio::error::eof ||
+                   ec == boost::asio::error::bad_descriptor ||
+                   ec == boost::asio::error::broken_pipe ||
+                   ec == boost::system::errc::io_error ||
+                   ec == boost::system::errc::no_such_device ||
+                   ec == boost::system::errc::no_such_device_or_address;
+        }
+
+        /// True for failures caused by noise on the line or a port glitch rather than by the
+        /// request itself.
+        auto is_transient(const error_code & ec) noexcept -> bool {
+            return is_port_error(ec) ||
+                   ec == boost::asio::error::timed_out ||
+                   ec == boost::system::errc::protocol_error ||
+                   ec == make_error_code(error::checksum_);
+        }
+
+        /// Back-off jitter source, per thread as retries may be planned on the bus thread and by
+        /// the io thread.
+        auto jitter() noexcept -> std::minstd_rand & {
+            thread_local auto engine = std::minstd_rand{ std::random_device{}() };
+            return engine;
+        }
+
+#if !defined(_WIN32)
+        /// Applies options to the calling thread.
+        auto configure_this_thread(const dedicated_thread_options & options) noexcept -> error_code {
+            if (options.cpu) {
+                auto cpus = cpu_set_t{ };
+                CPU_ZERO(&cpus);
+                CPU_SET(*options.cpu, &cpus);
+                if (const auto err = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus)) {
+                    return { err, boost::system::system_category() };
+                }
+            }
+            if (options.fifo_priority) {
+                auto param = sched_param{ };
+                param.sched_priority = *options.fifo_priority;
+                if (const auto err = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param)) {
+                    return { err, boost::system::system_category() };
+                }
+            }
+            return { };
+        }
+#endif
+    }
+
+    bus::bus(boost::asio::io_service & service, std::string_view device)
+        : _device{ device }
+        , _port{ service, _device }
+        , _reconnect_timer{ service }
+        , _reconnect_backoff{ first_reconnect_backoff }
+        , _retry_policy{ }
+        , _retry_tokens{ static_cast<long>(_retry_policy.budget_cap * token_scale) }
+    {
+        _port.set_option(boost::asio::serial_port::baud_rate{ 9600 });
+    }
+
+    bus::~bus() {
+        if (_thread.joinable()) {
+            {
+                auto lock = std::lock_guard{ _wake_mutex };
+                _stopping = true;
+            }
+            _wake.notify_one();
+            _thread.join();
+        }
+    }
+
+    auto bus::open() noexcept -> error_code {
+        auto ec = error_code{ };
+        _port.close(ec);
+        _port.open(_device, ec);
+        if (!ec) {
+            _port.set_option(boost::asio::serial_port::baud_rate{ 9600 }, ec);
+        }
+        return ec;
+    }
+
+    auto bus::get_io_service() noexcept -> boost::asio::io_service & {
+        return _port.get_io_service();
+    }
+
+    auto bus::port() noexcept -> boost::asio::serial_port & {
+        return _port;
+    }
+
+    auto bus::submit(dialog & d) noexcept -> void {
+        (d.is_background() ? _background : _queue).push(d);
+        if (_pending.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            // The bus was idle, this thread is responsible for getting it going again.  The dialog
+            // must be started on the io (or bus) thread, so hand over rather than starting it here.
+            dispatch_start_next();
+        }
+        else if (!_connected.load(std::memory_order_acquire)) {
+            // The bus may be waiting for the port to be reopened, hold the dialog now so its
+            // deadline is kept rather than noticed when the next attempt is due
+            if (_dedicated.load(std::memory_order_acquire)) {
+                {
+                    auto lock = std::lock_guard{ _wake_mutex };
+                    _hold_pending = true;
+                }
+                _wake.notify_one();
+            }
+            else {
+                get_io_service().post([this] {
+                    if (_parked) {
+                        park();
+                    }
+                });
+            }
+        }
+    }
+
+    auto bus::dispatch_start_next() noexcept -> void {
+        if (!_dedicated.load(std::memory_order_acquire)) {
+            get_io_service().post([this] { start_next(); });
+            return;
+        }
+        {
+            auto lock = std::lock_guard{ _wake_mutex };
+            _wake_pending = true;
+        }
+        _wake.notify_one();
+    }
+
+    auto bus::release() noexcept -> void {
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+            start_next();
+        }
+    }
+
+    auto bus::try_acquire() noexcept -> bool {
+        auto idle = std::size_t{ 0 };
+        if (!_pending.compare_exchange_strong(idle, 1, std::memory_order_acq_rel)) {
+            return false;
+        }
+        if (!_connected.load(std::memory_order_acquire)) {
+            release_acquired();
+            return false;
+        }
+        return true;
+    }
+
+    auto bus::release_acquired(const error_code & ec) noexcept -> void {
+        if (is_port_error(ec)) {
+            // Hand the bus, still owned, to the io (or bus) thread to reopen the port.  Nothing
+            // else may use the port meanwhile, try_acquire fails while disconnected and queued
+            // dialogs wait for the bus.
+            _connected = false;
+            auto ignored = error_code{ };
+            _port.close(ignored);
+            if (_dedicated.load(std::memory_order_acquire)) {
+                {
+                    auto lock = std::lock_guard{ _wake_mutex };
+                    _wake_pending = true;
+                    _handed_over = true;
+                }
+                _wake.notify_one();
+            }
+            else {
+                get_io_service().post([this] {
+                    _handed_over = true;
+                    park();
+                });
+            }
+            return;
+        }
+
+        if (_pending.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+            // Dialogs were submitted while the port was in use, they must be started on the io
+            // (or bus) thread.
+            dispatch_start_next();
+        }
+    }
+
+    auto bus::run_on_dedicated_thread(const dedicated_thread_options & options) -> error_code {
+#if !defined(_WIN32)
+        if (_thread.joinable()) {
+            return make_error_code(boost::system::errc::operation_in_progress);
+        }
+
+        _spin = options.spin;
+
+        // The thread configures itself, report whether that worked before committing to it
+        auto started = std::promise<error_code>{ };
+        auto result = started.get_future();
+        _thread = std::thread{ [this, options, started = std::move(started)]() mutable {
+            const auto ec = configure_this_thread(options);
+            started.set_value(ec);
+            if (!ec) {
+                run_dedicated();
+            }
+        } };
+
+        if (const auto ec = result.get()) {
+            _thread.join();
+            return ec;
+        }
+        _dedicated.store(true, std::memory_order_release);
+        return { };
+#else
+        return make_error_code(boost::system::errc::operation_not_supported);
+#endif
+    }
+
+    auto bus::run_dedicated() noexcept -> void {
+        for (;;) {
+            auto reconnect_first = false;
+            {
+                auto lock = std::unique_lock{ _wake_mutex };
+                _wake.wait(lock, [this] { return _wake_pending || _stopping; });
+                if (_stopping) {
+                    return;
+                }
+                _wake_pending = false;
+                reconnect_first = std::exchange(_handed_over, false);
+            }
+
+            if (reconnect_first) {
+                // Handed over by a synchronous exchange which broke the port, the bus is owned on
+                // its behalf until reopened.
+                reconnect_dedicated();
+                if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    continue;
+                }
+            }
+            drain_dedicated();
+        }
+    }
+
+    auto bus::drain_dedicated() noexcept -> void {
+        for (;;) {
+            // _pending guarantees a dialog has been pushed, but the producer may not have finished
+            // linking it into the queue yet.
+            auto next = pop_next();
+            while (next == nullptr) {
+                std::this_thread::yield();
+                next = pop_next();
+            }
+
+            // The dialog completes before the port is reopened, its count keeps the bus owned
+            // until then.
+            if (const auto ec = next->run_inline(_spin); is_port_error(ec)) {
+                _connected = false;
+                auto ignored = error_code{ };
+                _port.close(ignored);
+                reconnect_dedicated();
+            }
+
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return;
+            }
+        }
+    }
+
+    auto bus::reconnect_dedicated() noexcept -> void {
+        auto backoff = first_reconnect_backoff;
+        for (;;) {
+            if (!open()) {
+                _connected = true;
+                return;
+            }
+
+            // Until the next attempt, fail held dialogs as their deadlines pass rather than keeping
+            // them waiting.  Dialogs submitted meanwhile wake the thread to be held too.
+            const auto reopen = std::chrono::steady_clock::now() + backoff;
+            for (;;) {
+                auto wake = reopen;
+                if (const auto earliest = hold_queued(); earliest && *earliest < wake) {
+                    wake = *earliest;
+                }
+
+                auto lock = std::unique_lock{ _wake_mutex };
+                _wake.wait_until(lock, wake, [this] { return _stopping || _hold_pending; });
+                if (_stopping) {
+                    return;
+                }
+                _hold_pending = false;
+                if (std::chrono::steady_clock::now() >= reopen) {
+                    break;
+                }
+            }
+            backoff = std::min(backoff * 2, max_reconnect_backoff);
+        }
+    }
+
+    auto bus::report_error(const error_code & ec) noexcept -> void {
+        if (!_connected || !is_port_error(ec)) {
+            return;
+        }
+
+        // Any other operation on the port would fail the same way, stop using it.  The active
+        // dialog completes with this error and the next one finds the bus parked.
+        _connected = false;
+        auto ignored = error_code{ };
+        _port.close(ignored);
+        schedule_reconnect();
+    }
+
+    auto bus::park() noexcept -> void {
+        _parked = true;
+        if (!_reconnecting) {
+            schedule_reconnect();
+            return;
+        }
+
+        // Already waiting to reconnect, but dialogs queued since may have an earlier deadline
+        if (const auto earliest = hold_queued(); earliest && *earliest < _reconnect_timer.expires_at()) {
+            arm_reconnect_timer(*earliest);
+        }
+    }
+
+    auto bus::schedule_reconnect() noexcept -> void {
+        if (_reconnecting) {
+            return;
+        }
+        _reconnecting = true;
+
+        auto wake = std::chrono::steady_clock::now() + _reconnect_backoff;
+        if (_parked) {
+            // Wake in time to fail any held dialog whose deadline comes first
+            if (const auto earliest = hold_queued(); earliest && *earliest < wake) {
+                wake = *earliest;
+            }
+        }
+
+        arm_reconnect_timer(wake);
+    }
+
+    auto bus::arm_reconnect_timer(std::chrono::steady_clock::time_point wake) noexcept -> void {
+        // Moving the expiry cancels the previous wait, unless it has already completed.  Only the
+        // latest wait may act.
+        const auto generation = ++_reconnect_generation;
+        _reconnect_timer.expires_at(wake);
+        _reconnect_timer.async_wait([this, generation](const error_code & ec) {
+            if (!ec && generation == _reconnect_generation) {
+                on_reconnect_timer();
+            }
+        });
+    }
+
+    auto bus::on_reconnect_timer() noexcept -> void {
+        _reconnecting = false;
+
+        if (!_parked && _pending.load(std::memory_order_acquire) != 0) {
+            // The port may be in use by a synchronous exchange on another thread, try later
+            schedule_reconnect();
+            return;
+        }
+
+        if (!open()) {
+            _connected = true;
+            _reconnect_backoff = first_reconnect_backoff;
+            if (_parked) {
+                _parked = false;
+                // Drop the hold kept for a synchronous exchange which broke the port
+                if (std::exchange(_handed_over, false) &&
+                    _pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    return;
+                }
+                start_next();
+            }
+            return;
+        }
+
+        _reconnect_backoff = std::min(_reconnect_backoff * 2, max_reconnect_backoff);
+        schedule_reconnect();
+    }
+
+    auto bus::hold_queued() noexcept -> std::optional<std::chrono::steady_clock::time_point> {
+        while (const auto d = pop_queued()) {
+            _held.push_back(d);
+        }
+
+        auto earliest = std::optional<std::chrono::steady_clock::time_point>{ };
+        for (auto it = _held.begin(); it != _held.end(); ) {
+            if ((*it)->drop_if_stale()) {
+                it = _held.erase(it);
+                if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    // Nothing left, the next submission restarts the bus
+                    _parked = false;
+                }
+                continue;
+            }
+            if (const auto & deadline = (*it)->_deadline; deadline && (!earliest || *deadline < *earliest)) {
+                earliest = deadline;
+            }
+            ++it;
+        }
+        return earliest;
+    }
+
+    auto bus::set_retry_policy(const retry_policy & policy) noexcept -> void {
+        _retry_policy = policy;
+        _retry_tokens = static_cast<long>(policy.budget_cap * token_scale);
+    }
+
+    auto bus::record_success() noexcept -> void {
+        const auto cap = static_cast<long>(_retry_policy.budget_cap * token_scale);
+        const auto earned = static_cast<long>(_retry_policy.budget_ratio * token_scale);
+        auto tokens = _retry_tokens.load(std::memory_order_relaxed);
+        while (tokens < cap && !_retry_tokens.compare_exchange_weak(tokens, std::min(cap, tokens + earned),
+                                                                     std::memory_order_relaxed)) {
+        }
+    }
+
+    auto bus::plan_retry(const error_code & ec, int attempts,
+                         const std::optional<std::chrono::steady_clock::time_point> & deadline) noexcept
+        -> std::optional<std::chrono::steady_clock::duration>
+    {
+        const auto cost = static_cast<long>(token_scale);
+        if (!is_transient(ec) || attempts >= _retry_policy.max_attempts ||
+            _retry_tokens.load(std::memory_order_relaxed) < cost) {
+            return std::nullopt;
+        }
+
+        // Full jitter: a uniformly random wait up to the exponential back-off, so requests which
+        // failed together on a burst of noise do not retry together.
+        const auto shift = std::min(attempts - 1, 16);
+        const auto ceiling = std::min(_retry_policy.base_backoff * (1 << shift), _retry_policy.max_backoff);
+        const auto wait = std::chrono::milliseconds{
+            std::uniform_int_distribution<long long>{ 0, ceiling.count() }(jitter())
+        };
+
+        if (deadline && std::chrono::steady_clock::now() + wait >= *deadline) {
+            return std::nullopt;
+        }
+
+        // Another thread may have taken the last retry since the check above
+        auto tokens = _retry_tokens.load(std::memory_order_relaxed);
+        do {
+            if (tokens < cost) {
+                return std::nullopt;
+            }
+        } while (!_retry_tokens.compare_exchange_weak(tokens, tokens - cost, std::memory_order_relaxed));
+        return std::chrono::steady_clock::duration{ wait };
+    }
+
+    auto bus::pop_next() noexcept -> dialog * {
+        if (!_held.empty()) {
+            const auto next = _held.front();
+            _held.pop_front();
+            return next;
+        }
+        return pop_queued();
+    }
+
+    auto bus::pop_queued() noexcept -> dialog * {
+        if (const auto next = _queue.try_pop()) {
+            return next;
+        }
+        return _background.try_pop();
+    }
+
+    auto bus::start_next() noexcept -> void {
+        for (;;) {
+            if (!_connected) {
+                park();
+                return;
+            }
+
+            // _pending guarantees a dialog has been pushed, but the producer may not have finished
+            // linking it into the queue yet.
+            auto next = pop_next();
+            while (next == nullptr) {
+                std::this_thread::yield();
+                next = pop_next();
+            }
+
+            if (next->start()) {
+                return;
+            }
+
+            // The dialog was dropped without using the port, move straight on to the next one
+            if (_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return;
+            }
+        }
+    }
+} // namespace edwards::internal
@@ -1,21 +1,55 @@
 #include <edwards/internal/dialog.hpp>
+#include <edwards/internal/blocking_exchange.hpp>
 
 #include <algorithm>
+#include <cassert>
+#include <cstdlib>
 #include <iterator>
 
 #include <boost/asio.hpp>
 
 namespace edwards::internal {
-    dialog::dialog(boost::asio::serial_port & port) noexcept
-        : _port{ std::addressof(port) }
-        , _timer{ port.get_io_service() }
+    auto check_response(std::string_view response) -> error_code {
+        assert(response.length() >= 12);
+
+        if (response[6] != '*') {
+            const auto l = response.length();
+
+            // Parse one or two digit code into an int
+            const auto code = std::atoi(&response[l - 3]);
+
+            // If not the OK code, create an error code
+            if (code != 0) {
+                return { code, edwards_category() };
+            }
+        }
+
+        return { };
+    }
+
+#if EDWARDS_ENABLE_TRACING
+#   define EDWARDS_DIALOG_TRACE(event) trace(event)
+#else
+#   define EDWARDS_DIALOG_TRACE(event) ((void)0)
+#endif
+
+    dialog::dialog(bus & b, const request_options & options, const exchange_class & kind) noexcept
+        : _bus{ std::addressof(b) }
+        , _timer{ b.get_io_service() }
         , _message{ }
         , _result{ }
         , _resume_handle{ nullptr }
+        , _deadline{ options.deadline }
+        , _cancellation{ options.cancellation ? options.cancellation->_state : nullptr }
+        , _kind{ kind }
+        , _priority{ options.priority }
+        , _attempts{ 0 }
+        , _active{ false }
+        , _abandoned{ false }
     { }
 
     auto dialog::get_io_service() noexcept -> boost::asio::io_service & {
-        return _port->get_io_service();
+        return _bus->get_io_service();
     }
 
     auto dialog::await_ready() noexcept -> bool {
@@ -24,21 +58,123 @@ namespace edwards::internal {
 
     auto dialog::await_suspend(std::experimental::coroutine_handle<> handle) -> void {
         _resume_handle = handle;
+#if EDWARDS_ENABLE_TRACING
+        _trace_id = next_trace_id();
+        record_trace(trace_event::enqueue, _trace_id, (_message[1] - '0') * 10 + (_message[2] - '0'), &_message[6]);
+#endif
+        if (_cancellation) {
+            // Must be visible before we can be started, see cancellation_source::cancel
+            _cancellation->service.store(&get_io_service());
+        }
+        _bus->submit(*this);
+    }
+
+    auto dialog::drop_if_stale() noexcept -> bool {
+        auto dropped = error_code{};
+        if (_cancellation && _cancellation->cancelled.load()) {
+            dropped = make_error_code(boost::system::errc::operation_canceled);
+        }
+        else if (_deadline && *_deadline <= std::chrono::steady_clock::now()) {
+            dropped = boost::asio::error::timed_out;
+        }
+
+        if (dropped) {
+            // Nobody is waiting for the answer, don't spend bus time on it
+            _result.ec = dropped;
+            if (dropped == boost::asio::error::timed_out) {
+                EDWARDS_DIALOG_TRACE(trace_event::timeout);
+            }
+            EDWARDS_DIALOG_TRACE(trace_event::complete);
+            resume();
+            return true;
+        }
+        return false;
+    }
+
+    auto dialog::start() noexcept -> bool {
+        if (drop_if_stale()) {
+            return false;
+        }
+
+        _active = true;
+        ++_attempts;
+        if (_cancellation) {
+            _cancellation->active = this;
+        }
 
         // Start communication
+        EDWARDS_DIALOG_TRACE(trace_event::write_start);
+        // Only the message itself, the rest of the buffer would be sent as NULs
+        const auto message = view_message(_message);
         boost::asio::async_write(
-            *_port,
-            boost::asio::buffer(_message),
+            _bus->port(),
+            boost::asio::buffer(message.data(), message.size()),
             [this](const error_code & ec, std::size_t written) { on_write_complete(ec, written); });
+        return true;
+    }
+
+    auto dialog::run_inline(std::chrono::microseconds spin) noexcept -> error_code {
+        if (drop_if_stale()) {
+            // Already resumed, this may no longer exist
+            return { };
+        }
+
+        ++_attempts;
+        auto deadline = std::chrono::steady_clock::now() + response_timeout;
+        if (_deadline && *_deadline < deadline) {
+            deadline = *_deadline;
+        }
+
+        // Cancellation is polled by the exchange rather than abandoning it through the io thread
+        EDWARDS_DIALOG_TRACE(trace_event::write_start);
+#if !defined(_WIN32)
+#   if EDWARDS_ENABLE_TRACING
+        const auto trace_id = _trace_id;
+#   else
+        const auto trace_id = std::uint32_t{ 0 };
+#   endif
+        const auto ec = exchange_on_port(_bus->port().native_handle(), _message, _result.response, deadline, spin,
+                                         _cancellation ? &_cancellation->cancelled : nullptr, trace_id);
+#else
+        // Never reached, the bus cannot have a dedicated thread on Windows
+        const auto ec = make_error_code(boost::system::errc::operation_not_supported);
+#endif
+        if (complete(ec)) {
+            resume();
+        }
+        return ec;
+    }
+
+    auto dialog::resume() noexcept -> void {
+        // Always through the io_service, even from the dedicated thread: the code awaiting the
+        // result (pollers, collectors, user continuations) expects to run on the io thread, and
+        // must not hold up the next exchange.
+        get_io_service().post(_resume_handle);
+    }
+
+    auto dialog::is_background() const noexcept -> bool {
+        return _priority == request_priority::background;
+    }
+
+    auto dialog::abandon() noexcept -> void {
+        if (_active && !_abandoned) {
+            _abandoned = true;
+            _bus->port().cancel();
+        }
     }
 
     auto dialog::await_resume() noexcept -> dialog_result {
+#if EDWARDS_ENABLE_TRACING
+        _result.trace_id = _trace_id;
+#endif
         return _result;
     }
 
     auto dialog::on_write_complete(const error_code & ec, std::size_t) noexcept -> void {
+        EDWARDS_DIALOG_TRACE(trace_event::write_end);
         if (ec) {
             // There was an error while sending the message
+            _bus->report_error(ec);
             signal_completion(ec);
             return;
         }
@@ -46,8 +182,13 @@ namespace edwards::internal {
         // Read response from device
         start_read();
 
-        // Setup timer which will cancel read operation if it takes too long to complete.
-        _timer.expires_from_now(boost::posix_time::milliseconds{ 500 });
+        // Setup timer which will cancel read operation if it takes too long to complete, or
+        // overruns the deadline of the request.
+        auto expiry = std::chrono::steady_clock::now() + response_timeout;
+        if (_deadline && *_deadline < expiry) {
+            expiry = *_deadline;
+        }
+        _timer.expires_at(expiry);
         _timer.async_wait([this](const error_code & ec) {
             on_timeout(ec);
         });
@@ -55,7 +196,7 @@ namespace edwards::internal {
 
     auto dialog::start_read() noexcept -> void {
         boost::asio::async_read(
-            *_port,
+            _bus->port(),
             boost::asio::buffer(_result.response),
             [this](const error_code & ec, std::size_t read) { return on_read_packet(ec, read); },
             [this](const error_code & ec, std::size_t read) { on_read_complete(ec, read); }
@@ -63,6 +204,12 @@ namespace edwards::internal {
     }
 
     auto dialog::on_read_packet(const error_code & ec, std::size_t read) noexcept -> std::size_t {
+#if EDWARDS_ENABLE_TRACING
+        if (read > 0 && !_first_byte) {
+            _first_byte = true;
+            trace(trace_event::first_byte);
+        }
+#endif
         if (ec || _result.response[read - 1] == '\r') {
             return 0;
         }
@@ -73,8 +220,10 @@ namespace edwards::internal {
         using namespace boost::asio::error;
 
         if (ec) {
-            // An error occured during the read
-            signal_completion(ec == operation_aborted ? timed_out : ec);
+            // An error occured during the read, the read is aborted either by the timer or by
+            // abandoning the dialog
+            _bus->report_error(ec);
+            signal_completion(ec == operation_aborted ? error_code{ timed_out } : ec);
             return;
         }
         else if (_message[1] != _result.response[1] ||
@@ -92,20 +241,79 @@ namespace edwards::internal {
             }
         }
         else {
-            // Read completed successfully, no longer need the timer running.
-            _timer.cancel();
-            signal_completion(error_code{ });
+            // Read completed successfully, pass on any error reported by the device
+            signal_completion(check_response(view_message(_result)));
         }
     }
 
     auto dialog::on_timeout(const error_code & ec) noexcept -> void {
-        if (!ec) {
-            _port->cancel();
+        // The timer may have expired just as the read completed, in which case the port may
+        // already belong to another dialog.
+        if (!ec && _active) {
+            EDWARDS_DIALOG_TRACE(trace_event::timeout);
+            _bus->port().cancel();
         }
     }
 
     auto dialog::signal_completion(const error_code & ec) -> void {
-        _result.ec = ec;
-        get_io_service().post(_resume_handle);
+        const auto done = complete(ec);
+
+        // Hand the port to the next dialog before resuming, the awaiting coroutine may destroy this
+        // dialog as soon as it runs.
+        _bus->release();
+        if (done) {
+            get_io_service().post(_resume_handle);
+        }
+    }
+
+    auto dialog::complete(const error_code & ec) -> bool {
+        _result.ec = _abandoned ? make_error_code(boost::system::errc::operation_canceled) : ec;
+        if (!_result.ec && _kind.validate) {
+            _result.ec = _kind.validate(view_data(_result));
+        }
+        _timer.cancel();
+
+        if (!_result.ec) {
+            _bus->record_success();
+        }
+        else if (_kind.retry == idempotency::idempotent && !_abandoned) {
+            if (const auto backoff = _bus->plan_retry(_result.ec, _attempts, _deadline)) {
+                EDWARDS_DIALOG_TRACE(trace_event::retry);
+                retry_after(*backoff);
+                return false;
+            }
+        }
+
+        _active = false;
+        if (_cancellation && _cancellation->active == this) {
+            _cancellation->active = nullptr;
+        }
+
+        EDWARDS_DIALOG_TRACE(trace_event::complete);
+        return true;
+    }
+
+    auto dialog::retry_after(std::chrono::steady_clock::duration backoff) -> void {
+        _active = false;
+        if (_cancellation && _cancellation->active == this) {
+            _cancellation->active = nullptr;
+        }
+
+        // The read timer's cancelled wait may still be queued, it is harmless as it sees
+        // operation_aborted.  Cancellation during the back-off is noticed by start() once queued.
+        _timer.expires_from_now(backoff);
+        _timer.async_wait([this](const error_code &) {
+            _result = dialog_result{ };
+#if EDWARDS_ENABLE_TRACING
+            _first_byte = false;
+#endif
+            _bus->submit(*this);
+        });
+    }
+
+#if EDWARDS_ENABLE_TRACING
+    auto dialog::trace(trace_event event) const noexcept -> void {
+        record_trace(event, _trace_id, (_message[1] - '0') * 10 + (_message[2] - '0'));
     }
-} // namespace edwards::internal
\ No newline at end of file
+#endif
+} // namespace edwards::internal
@@ -0,0 +1,98 @@
+#include <edwards/internal/parse.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+#include <boost/system/error_code.hpp>
+
+namespace edwards::internal {
+    namespace {
+        auto protocol_error() -> error_code {
+            return { boost::system::errc::protocol_error, boost::system::generic_category() };
+        }
+    }
+
+    // Successful response data to ?S851 is "xxxxxxx;yyyyyyyyyy;zzzz"
+    //   x - pump type
+    //   y - DSP software version
+    //   z - full speed in Hz
+    auto parse_pump_info(std::string_view data) -> result<pump_info> {
+        if (data.size() < 20 || data[7] != ';' || data[18] != ';') {
+            return protocol_error();
+        }
+        return pump_info{
+            std::string{ data.substr(0, 7) },
+            std::string{ data.substr(8, 10) },
+            static_cast<hertz_t>(std::strtoul(&data[19], nullptr, 10))
+        };
+    }
+
+    // Response data to ?V852 is "speed;status", speed in Hz and status as hex
+    auto parse_speed_status(std::string_view data) -> result<pump_speed_status> {
+        const auto status_start = data.find_first_of(';');
+        if (data.empty() || status_start == std::string_view::npos) {
+            return protocol_error();
+        }
+        return pump_speed_status{
+            static_cast<hertz_t>(std::strtoul(data.data(), nullptr, 10)),
+            static_cast<nEXT_status>(std::strtoul(&data[status_start + 1], nullptr, 16))
+        };
+    }
+
+    auto parse_vent_mode(std::string_view data) -> result<vent_mode> {
+        if (data.size() != 1 || !std::isdigit(data[0])) {
+            return protocol_error();
+        }
+        return static_cast<vent_mode>(data[0] - '0');
+    }
+
+    /// Parses response data consisting of a single decimal integer.
+    auto parse_integer(std::string_view data) -> result<long> {
+        if (data.empty() || !std::isdigit(data[0])) {
+            return protocol_error();
+        }
+        return std::strtol(data.data(), nullptr, 10);
+    }
+
+    // Response data to ?V859 is "motor;controller", both in degrees celsius
+    auto parse_temperature(std::string_view data) -> result<pump_temperature> {
+        const auto controller_start = data.find_first_of(';');
+        if (data.empty() || controller_start == std::string_view::npos) {
+            return protocol_error();
+        }
+        return pump_temperature{
+            celsius_t{ static_cast<double>(std::strtol(data.data(), nullptr, 10)) },
+            celsius_t{ static_cast<double>(std::strtol(&data[controller_start + 1], nullptr, 10)) }
+        };
+    }
+
+    // Response data to ?S868 is the version string of the PIC, e.g. "D39618000A"
+    auto parse_PIC_version(std::string_view data) -> result<std::string> {
+        const auto printable = [](char c) { return std::isprint(static_cast<unsigned char>(c)) && c != ';'; };
+        if (data.empty() || !std::all_of(data.begin(), data.end(), printable)) {
+            return protocol_error();
+        }
+        return std::string{ data };
+    }
+
+    // Response data to the run time queries is "hours;hours"
+    auto parse_run_hours(std::string_view data) -> result<run_hours> {
+        const auto second_start = data.find_first_of(';');
+        if (data.empty() || !std::isdigit(data[0]) || second_start == std::string_view::npos) {
+            return protocol_error();
+        }
+        return run_hours{
+            std::chrono::hours{ std::strtol(data.data(), nullptr, 10) },
+            std::chrono::hours{ std::strtol(&data[second_start + 1], nullptr, 10) }
+        };
+    }
+
+    // Response data to ?V886 is the service status word as hex
+    auto parse_service_status(std::string_view data) -> result<service_status> {
+        if (data.empty() || !std::isxdigit(data[0])) {
+            return protocol_error();
+        }
+        return static_cast<service_status>(std::strtoul(data.data(), nullptr, 16));
+    }
+} // namespace edwards::internal
@@ -0,0 +1,133 @@
+#include <edwards/maintenance_collector.hpp>
+
+#include <algorithm>
+#include <utility>
+
+#include <common/coroutines.hpp>
+
+namespace edwards {
+    namespace {
+        /// Stores the value of r in value, or its error in ec unless ec already holds one, keeping
+        /// the previous value.  Returns true if r held a value.
+        template<typename T>
+        auto update(const result<T> & r, std::optional<T> & value, error_code & ec) -> bool {
+            if (r) {
+                value = *r;
+                return true;
+            }
+            if (!ec) {
+                ec = r.error();
+            }
+            return false;
+        }
+    }
+
+    maintenance_collector::maintenance_collector(multidrop_network & network, std::chrono::steady_clock::duration interval)
+        : _network{ &network }
+        , _interval{ interval }
+        , _timer{ network.get_io_service() }
+    { }
+
+    auto maintenance_collector::add(multidrop_endpoint pump) -> void {
+        const auto lock = std::lock_guard<std::mutex>{ _mutex };
+        const auto it = std::find_if(_entries.begin(), _entries.end(),
+                                     [&](const entry & e) { return e.pump.get() == pump.get(); });
+        if (it == _entries.end()) {
+            _entries.push_back(entry{ pump, maintenance_record{ } });
+        }
+    }
+
+    auto maintenance_collector::remove(multidrop_endpoint pump) -> void {
+        const auto lock = std::lock_guard<std::mutex>{ _mutex };
+        _entries.erase(std::remove_if(_entries.begin(), _entries.end(),
+                                      [&](const entry & e) { return e.pump.get() == pump.get(); }),
+                       _entries.end());
+    }
+
+    auto maintenance_collector::start() -> void {
+        if (!_running) {
+            _running = true;
+            collect();
+        }
+    }
+
+    auto maintenance_collector::stop() -> void {
+        _running = false;
+        _timer.cancel();
+        _cancellation.cancel();
+        _cancellation = cancellation_source{ };
+    }
+
+    auto maintenance_collector::record(multidrop_endpoint pump) const -> std::optional<maintenance_record> {
+        const auto lock = std::lock_guard<std::mutex>{ _mutex };
+        const auto it = std::find_if(_entries.begin(), _entries.end(),
+                                     [&](const entry & e) { return e.pump.get() == pump.get(); });
+        if (it == _entries.end()) {
+            return std::nullopt;
+        }
+        return it->record;
+    }
+
+    auto maintenance_collector::collect() -> void {
+        if (!_running) {
+            return;
+        }
+
+        // Every query is queued at once; being background requests they trickle out between the
+        // normal traffic rather than holding it up.
+        auto pumps = std::vector<multidrop_endpoint>{ };
+        {
+            const auto lock = std::lock_guard<std::mutex>{ _mutex };
+            for (const auto & e : _entries) {
+                pumps.push_back(e.pump);
+            }
+        }
+        for (const auto pump : pumps) {
+            collect_one(pump);
+        }
+
+        _timer.expires_from_now(_interval);
+        _timer.async_wait([this](const error_code & ec) {
+            if (!ec) {
+                collect();
+            }
+        });
+    }
+
+    auto maintenance_collector::collect_one(multidrop_endpoint pump) -> boost::future<void> {
+        // A collection not sent by the time the next one starts is superseded by it
+        auto options = within(_interval);
+        options.priority = request_priority::background;
+        options.cancellation = _cancellation;
+
+        auto controller = _network->try_controller_run_time(pump, options);
+        auto rotor = _network->try_pump_run_time(pump, options);
+        auto bearing = _network->try_bearing_run_time(pump, options);
+        auto service = _network->try_pump_service_status(pump, options);
+
+        const auto controller_hours = co_await std::move(controller);
+        const auto rotor_hours = co_await std::move(rotor);
+        const auto bearing_hours = co_await std::move(bearing);
+        const auto service_bits = co_await std::move(service);
+        if (options.cancellation->is_cancelled()) {
+            co_return;
+        }
+
+        const auto lock = std::lock_guard<std::mutex>{ _mutex };
+        const auto it = std::find_if(_entries.begin(), _entries.end(),
+                                     [&](const entry & e) { return e.pump.get() == pump.get(); });
+        if (it == _entries.end()) {
+            co_return;
+        }
+
+        auto & r = it->record;
+        r.ec = error_code{ };
+        auto any = update(controller_hours, r.controller_run_time, r.ec);
+        any |= update(rotor_hours, r.pump_run_time, r.ec);
+        any |= update(bearing_hours, r.bearing_run_time, r.ec);
+        any |= update(service_bits, r.service, r.ec);
+        if (any) {
+            r.updated = std::chrono::system_clock::now();
+        }
+    }
+} // namespace edwards
@@ -1,17 +1,16 @@
 #include <edwards/multidrop_network.hpp>
+#include <edwards/shared_state.hpp>
+#include <edwards/internal/blocking_exchange.hpp>
+#include <edwards/internal/delay.hpp>
 #include <edwards/internal/dialog.hpp>
+#include <edwards/internal/parse.hpp>
+#include <edwards/internal/trace.hpp>
 
-#include <algorithm>
-#include <cstdlib>
+#include <limits>
+#include <type_traits>
 #include <utility>
-#include <future>
-#include <condition_variable>
-#include <optional>
-#include <variant>
 
-#include <boost/asio/read_until.hpp>
 #include <boost/system/error_code.hpp>
-#include <fmt/format.h>
 
 #include <common/coroutines.hpp>
 
@@ -19,271 +18,614 @@ using namespace std::chrono_literals;
 
 namespace edwards {
     namespace {
-        error_code check_response(std::string_view response) {
-            assert(response.length() >= 12);
+        template<auto Parse>
+        auto validate(std::string_view data) -> error_code {
+            return Parse(data).error();
+        }
+
+        // Queries are repeated by the dialog on a timeout or a reply which fails to parse
+        template<auto Parse>
+        constexpr auto query = internal::exchange_class{ internal::idempotency::idempotent, &validate<Parse> };
+
+        // Setting an absolute value, or closing a valve, twice leaves the pump as setting it once
+        constexpr auto idempotent_command = internal::exchange_class{ internal::idempotency::idempotent, nullptr };
+
+        // Commands whose effect is read back before being repeated, see send_verified
+        constexpr auto verified_command = internal::exchange_class{ internal::idempotency::verify_first, nullptr };
 
-            if (response[6] != '*') {
-                const auto l = response.length();
+        template<typename T>
+        struct is_result : std::false_type { };
 
-                // Parse one or two digit code into an int
-                const auto code = std::atoi(&response[l - 3]);
+        template<typename T>
+        struct is_result<result<T>> : std::true_type { };
+
+        /// The failure of a request in the form Out its caller asked for: the error itself in a
+        /// result, or thrown as system_error for the plain forms.
+        template<typename Out>
+        auto fail(const error_code & ec) -> Out {
+            if constexpr (is_result<Out>::value) {
+                return Out{ ec };
+            }
+            else {
+                throw EDWARDS_ERROR_NS::system_error{ ec };
+            }
+        }
+
+        /// The outcome of a request in the form Out its caller asked for.
+        template<typename Out, typename T>
+        auto deliver(result<T> outcome) -> Out {
+            if constexpr (is_result<Out>::value) {
+                return outcome;
+            }
+            else {
+                return std::move(outcome).value();
+            }
+        }
 
-                // If not the OK code, create an error code
-                if (code != 0) {
-                    return { code, edwards_category() };
-                }
+        /// Adapts a try_ form to the error code forms, which report failure through ec and a
+        /// default constructed value.
+        template<typename T>
+        auto assign_error(boost::future<result<T>> request, error_code & ec) -> boost::future<T> {
+            auto outcome = co_await std::move(request);
+            ec = outcome.error();
+            if constexpr (!std::is_void_v<T>) {
+                co_return outcome ? std::move(*outcome) : T{ };
             }
+        }
 
-            return { };
+        /// Sends a command on the calling thread, see internal::exchange_blocking.
+        template<typename... Args>
+        auto command_blocking(internal::bus & b, const request_options & options, Args&&... args) -> result<void> {
+            auto message = internal::message_buffer{ };
+            fmt::ArrayWriter mesg{ message.data(), message.size() };
+            mesg.write(std::forward<Args>(args)...);
+
+            auto response = internal::message_buffer{ };
+            return internal::exchange_blocking(b, message, response, options);
+        }
+
+        /// Sends a query on the calling thread and parses the response data with Parse.
+        template<auto Parse, typename... Args>
+        auto query_blocking(internal::bus & b, const request_options & options, Args&&... args) {
+            auto message = internal::message_buffer{ };
+            fmt::ArrayWriter mesg{ message.data(), message.size() };
+            mesg.write(std::forward<Args>(args)...);
+
+            auto response = internal::message_buffer{ };
+            const auto ec = internal::exchange_blocking(b, message, response, options);
+            return ec ? decltype(Parse(std::string_view{})){ ec } : Parse(internal::view_data(response));
         }
     }
 
     multidrop_network::multidrop_network(boost::asio::io_service & service,
                                          std::string_view rs485_port)
-        : _port{ service, rs485_port.data() }
-    {
-        _port.set_option(boost::asio::serial_port::baud_rate{ 9600 });
+        : _bus{ service, rs485_port }
+    { }
+
+    auto multidrop_network::get_io_service() noexcept -> boost::asio::io_service & {
+        return _bus.get_io_service();
+    }
+
+    auto multidrop_network::set_retry_policy(const retry_policy & policy) noexcept -> void {
+        _bus.set_retry_policy(policy);
+    }
+
+    auto multidrop_network::run_on_dedicated_thread(const dedicated_thread_options & options) -> error_code {
+        return _bus.run_on_dedicated_thread(options);
+    }
+
+    auto multidrop_network::publish_to(state_publisher * publisher) noexcept -> void {
+        _publisher.store(publisher, std::memory_order_release);
     }
 
-    template<typename... Args>
-    auto multidrop_network::send_message(error_code & ec, Args&&... args) -> boost::future<void> {
-        const auto result = co_await internal::dialog{ _port, std::forward<Args>(args)... };
-        if (result.ec) {
-            // Error during communication
-            ec = result.ec;
+    auto multidrop_network::publish_status(multidrop_endpoint pump, hertz_t speed, nEXT_status status) noexcept -> void {
+        if (const auto publisher = _publisher.load(std::memory_order_acquire)) {
+            publisher->publish_status(pump, speed, status);
         }
-        else {
-            // No communication error, get error code in response.
-            ec = check_response(internal::view_message(result));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_info_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_pump_info>, "#{:02d}:00?S851\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
+        co_return deliver<Out>(internal::parse_pump_info(internal::view_data(reply)));
+    }
+
+    auto multidrop_network::try_pump_info(multidrop_endpoint pump, request_options options) -> boost::future<result<::edwards::pump_info>> {
+        return pump_info_as<result<::edwards::pump_info>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_info(multidrop_endpoint pump, request_options options) -> boost::future<::edwards::pump_info> {
+        return pump_info_as<::edwards::pump_info>(pump, std::move(options));
+    }
+
+    auto multidrop_network::try_start_pump(multidrop_endpoint pump, request_options options) -> boost::future<result<void>> {
+        return send_verified<result<void>>(pump, std::move(options), "#{:02d}:00!C852 1\r", &multidrop_network::is_started);
+    }
+
+    auto multidrop_network::start_pump(multidrop_endpoint pump, request_options options) -> boost::future<void> {
+        return send_verified<void>(pump, std::move(options), "#{:02d}:00!C852 1\r", &multidrop_network::is_started);
+    }
+
+    auto multidrop_network::try_stop_pump(multidrop_endpoint pump, request_options options) -> boost::future<result<void>> {
+        return send_verified<result<void>>(pump, std::move(options), "#{:02d}:00!C852 0\r", &multidrop_network::is_stopped);
     }
 
-    template<typename... Args>
-    auto multidrop_network::send_query(error_code & ec, Args&&... args) -> boost::future<internal::message_buffer> {
-        const auto result = co_await internal::dialog{ _port, std::forward<Args>(args)... };
-        if (result.ec) {
-            ec = result.ec;
+    auto multidrop_network::stop_pump(multidrop_endpoint pump, request_options options) -> boost::future<void> {
+        return send_verified<void>(pump, std::move(options), "#{:02d}:00!C852 0\r", &multidrop_network::is_stopped);
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_current_speed_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_speed_status>, "#{:02d}:00?V852\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
-        else {
-            ec = check_response(internal::view_message(result));
+        const auto parsed = internal::parse_speed_status(internal::view_data(reply));
+        if (!parsed) {
+            co_return fail<Out>(parsed.error());
         }
-        co_return result.response;
-    }
-
-    //boost::future<pump_info> multidrop_network::pump_info(multidrop_endpoint pump, error_code & ec) {
-    //    //const auto response = send_message(fmt::format("#{:02d}:00?S851\r", pump.get()));
-    //    //check_response(response);
-    //    //
-    //    //// Successful message format:
-    //    ////   #00:ii?S851 xxxxxxx;yyyyyyyyyy;zzzz\r
-    //    ////            '         '         '
-    //    ////   i - endpoint of the pump we're communicating with
-    //    ////   x - pump type
-    //    ////   y - DSP software version
-    //    ////   z - full speed rpm
-    //    //assert(response.length() == 36);
-
-
-    //    //return { std::string{ response.begin() + 13, response.begin() + 20 },
-    //    //         std::string{ response.begin() + 21, response.begin() + 31 },
-    //    //         std::atoi(response.data() + 32) };
-    //}
-
-    //auto multidrop_network::pump_power_limit(multidrop_endpoint pump, error_code & ec) -> boost::future<watt_t> {
-    //    dialog dia{ *this, fmt::format("#{:02d}:00?S855\r", pump.get()) };
-    //    if (ec = co_await dia.run()) {
-    //        // Error in serial communication
-    //        co_return watt_t{};
-    //    }
-    //    if (ec = dia.response_code()) {
-    //        // Error returned from pump
-    //        co_return watt_t{};
-    //    }
-
-    //    co_return watt_t{ std::strtoll(dia.response_data().data(), nullptr, 10) };
-    //}
+        publish_status(pump, parsed->speed, parsed->status);
+        co_return parsed->speed;
+    }
 
-    auto multidrop_network::get_io_service() noexcept -> boost::asio::io_service & {
-        return _port.get_io_service();
+    auto multidrop_network::try_pump_current_speed(multidrop_endpoint pump, request_options options) -> boost::future<result<hertz_t>> {
+        return pump_current_speed_as<result<hertz_t>>(pump, std::move(options));
     }
 
-    auto multidrop_network::pump_info(multidrop_endpoint pump, error_code & ec) -> boost::future<::edwards::pump_info> {
-        const auto response = co_await send_query(ec, "#{:02d}:00!S851 1\r", pump.get());
-        auto info = edwards::pump_info{};
-        if (!ec) {
-            const auto data = internal::view_data(response);
-            if (data[8] != ';' || data[18] != ';') {
-                ec.assign(boost::system::errc::protocol_error,
-                          boost::system::generic_category());
-            }
-            else {
-                info.type.assign(data.substr(0, 7));
-                info.DSP_version.assign(data.substr(8, 10));
-                info.max_speed = static_cast<hertz_t>(std::strtoul(&data[19], nullptr, 10));
-            }
-        }
-        co_return info;
+    auto multidrop_network::pump_current_speed(multidrop_endpoint pump, request_options options) -> boost::future<hertz_t> {
+        return pump_current_speed_as<hertz_t>(pump, std::move(options));
     }
 
-    auto multidrop_network::pump_info(multidrop_endpoint pump) -> boost::future<::edwards::pump_info> {
-        auto ec = error_code{};
-        const auto info = co_await pump_info(pump, ec);
-        if (ec) {
-            throw boost::system::system_error{ ec };
+    template<typename Out>
+    auto multidrop_network::pump_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_speed_status>, "#{:02d}:00?V852\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
+        }
+        const auto parsed = internal::parse_speed_status(internal::view_data(reply));
+        if (!parsed) {
+            co_return fail<Out>(parsed.error());
         }
-        co_return info;
+        publish_status(pump, parsed->speed, parsed->status);
+        co_return parsed->status;
     }
 
-    auto multidrop_network::start_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
-        return send_message(ec, "#{:02d}:00!C852 1\r", pump.get());
+    auto multidrop_network::try_pump_status(multidrop_endpoint pump, request_options options) -> boost::future<result<nEXT_status>> {
+        return pump_status_as<result<nEXT_status>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_status(multidrop_endpoint pump, request_options options) -> boost::future<nEXT_status> {
+        return pump_status_as<nEXT_status>(pump, std::move(options));
     }
 
-    auto multidrop_network::start_pump(multidrop_endpoint pump) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await start_pump(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
+    template<typename Out>
+    auto multidrop_network::pump_speed_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_speed_status>, "#{:02d}:00?V852\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
+        auto parsed = internal::parse_speed_status(internal::view_data(reply));
+        if (parsed) {
+            publish_status(pump, parsed->speed, parsed->status);
+        }
+        co_return deliver<Out>(std::move(parsed));
     }
 
-    auto multidrop_network::stop_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
-        return send_message(ec, "#{:02d}:00!C852 0\r", pump.get());
+    auto multidrop_network::try_pump_speed_status(multidrop_endpoint pump, request_options options) -> boost::future<result<::edwards::pump_speed_status>> {
+        return pump_speed_status_as<result<::edwards::pump_speed_status>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_speed_status(multidrop_endpoint pump, request_options options) -> boost::future<::edwards::pump_speed_status> {
+        return pump_speed_status_as<::edwards::pump_speed_status>(pump, std::move(options));
     }
 
-    auto multidrop_network::stop_pump(multidrop_endpoint pump) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await stop_pump(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
+    template<typename Out>
+    auto multidrop_network::pump_vent_mode_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_vent_mode>, "#{:02d}:00?S853\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
+        co_return deliver<Out>(internal::parse_vent_mode(internal::view_data(reply)));
     }
 
-    auto multidrop_network::pump_current_speed(multidrop_endpoint pump, error_code & ec) -> boost::future<hertz_t> {
-        const auto response = co_await send_query(ec, "#{:02d}:00?V852\r", pump.get());
-        if (!ec) {
-            const auto resp_data = internal::view_data(response);
-            co_return static_cast<hertz_t>(std::strtoul(resp_data.data(), nullptr, 10));
+    auto multidrop_network::try_pump_vent_mode(multidrop_endpoint pump, request_options options) -> boost::future<result<vent_mode>> {
+        return pump_vent_mode_as<result<vent_mode>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, request_options options) -> boost::future<vent_mode> {
+        return pump_vent_mode_as<vent_mode>(pump, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_vent_mode_as(multidrop_endpoint pump, vent_mode new_mode, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, idempotent_command, "#{:02d}:00!S853 {}\r", pump.get(), static_cast<int>(new_mode) };
+        co_return deliver<Out>(result<void>{ reply.ec });
+    }
+
+    auto multidrop_network::try_pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, request_options options) -> boost::future<result<void>> {
+        return pump_vent_mode_as<result<void>>(pump, new_mode, std::move(options));
+    }
+
+    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, request_options options) -> boost::future<void> {
+        return pump_vent_mode_as<void>(pump, new_mode, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_timer_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_integer>, "#{:02d}:00?S854\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
-        co_return hertz_t{ std::numeric_limits<double>::quiet_NaN() };
+        const auto minutes = internal::parse_integer(internal::view_data(reply));
+        if (!minutes) {
+            co_return fail<Out>(minutes.error());
+        }
+        co_return std::chrono::minutes{ *minutes };
+    }
+
+    auto multidrop_network::try_pump_timer(multidrop_endpoint pump, request_options options) -> boost::future<result<std::chrono::minutes>> {
+        return pump_timer_as<result<std::chrono::minutes>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_timer(multidrop_endpoint pump, request_options options) -> boost::future<std::chrono::minutes> {
+        return pump_timer_as<std::chrono::minutes>(pump, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_timer_as(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options) -> boost::future<Out> {
+        assert(new_timeout >= 1min && new_timeout <= 30min);
+
+        const auto reply = co_await internal::dialog{ _bus, options, idempotent_command, "#{:02d}:00!S854 {}\r", pump.get(), new_timeout.count() };
+        co_return deliver<Out>(result<void>{ reply.ec });
+    }
+
+    auto multidrop_network::try_pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options) -> boost::future<result<void>> {
+        return pump_timer_as<result<void>>(pump, new_timeout, std::move(options));
     }
 
-    auto multidrop_network::pump_current_speed(multidrop_endpoint pump) -> boost::future<hertz_t> {
-        auto ec = error_code{};
-        const auto speed = co_await pump_current_speed(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
+    auto multidrop_network::pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, request_options options) -> boost::future<void> {
+        return pump_timer_as<void>(pump, new_timeout, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_power_limit_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_integer>, "#{:02d}:00?S855\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
-        co_return speed;
+        const auto watts = internal::parse_integer(internal::view_data(reply));
+        if (!watts) {
+            co_return fail<Out>(watts.error());
+        }
+        co_return watt_t{ static_cast<double>(*watts) };
     }
 
-    auto multidrop_network::pump_status(multidrop_endpoint pump, error_code & ec) -> boost::future<nEXT_status> {
-        const auto response = co_await send_query(ec, "#{:02d}:00?V852\r", pump.get());
-        if (!ec) {
-            const auto resp_data = internal::view_data(response);
-            const auto status_start = resp_data.find_first_of(';');
-            if (status_start != std::string_view::npos) {
-                co_return static_cast<nEXT_status>(std::strtoul(&resp_data[status_start + 1], nullptr, 16));
-            }
-            else {
-                ec.assign(boost::system::errc::protocol_error,
-                          boost::system::generic_category());
+    auto multidrop_network::try_pump_power_limit(multidrop_endpoint pump, request_options options) -> boost::future<result<watt_t>> {
+        return pump_power_limit_as<result<watt_t>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_power_limit(multidrop_endpoint pump, request_options options) -> boost::future<watt_t> {
+        return pump_power_limit_as<watt_t>(pump, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_power_limit_as(multidrop_endpoint pump, watt_t new_limit, request_options options) -> boost::future<Out> {
+        assert(new_limit >= 50_W && new_limit <= 200_W);
+
+        const auto reply = co_await internal::dialog{ _bus, options, idempotent_command, "#{:02d}:00!S855 {}\r", pump.get(), units::unit_cast<int>(new_limit) };
+        co_return deliver<Out>(result<void>{ reply.ec });
+    }
+
+    auto multidrop_network::try_pump_power_limit(multidrop_endpoint pump, watt_t new_limit, request_options options) -> boost::future<result<void>> {
+        return pump_power_limit_as<result<void>>(pump, new_limit, std::move(options));
+    }
+
+    auto multidrop_network::pump_power_limit(multidrop_endpoint pump, watt_t new_limit, request_options options) -> boost::future<void> {
+        return pump_power_limit_as<void>(pump, new_limit, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_temp_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_temperature>, "#{:02d}:00?V859\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
+        }
+        auto temperature = internal::parse_temperature(internal::view_data(reply));
+        if (temperature) {
+            if (const auto publisher = _publisher.load(std::memory_order_acquire)) {
+                publisher->publish_temperature(pump, *temperature);
             }
         }
-        co_return nEXT_status{ 0 };
+        co_return deliver<Out>(std::move(temperature));
+    }
+
+    auto multidrop_network::try_pump_temp(multidrop_endpoint pump, request_options options) -> boost::future<result<pump_temperature>> {
+        return pump_temp_as<result<pump_temperature>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_temp(multidrop_endpoint pump, request_options options) -> boost::future<pump_temperature> {
+        return pump_temp_as<pump_temperature>(pump, std::move(options));
+    }
+
+    auto multidrop_network::try_factory_reset_pump(multidrop_endpoint pump, request_options options) -> boost::future<result<void>> {
+        return send_verified<result<void>>(pump, std::move(options), "#{:02d}:00!S867 1\r", &multidrop_network::is_factory_default);
+    }
+
+    auto multidrop_network::factory_reset_pump(multidrop_endpoint pump, request_options options) -> boost::future<void> {
+        return send_verified<void>(pump, std::move(options), "#{:02d}:00!S867 1\r", &multidrop_network::is_factory_default);
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_PIC_version_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_PIC_version>, "#{:02d}:00?S868\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
+        }
+        co_return deliver<Out>(internal::parse_PIC_version(internal::view_data(reply)));
+    }
+
+    auto multidrop_network::try_pump_PIC_version(multidrop_endpoint pump, request_options options) -> boost::future<result<std::string>> {
+        return pump_PIC_version_as<result<std::string>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_PIC_version(multidrop_endpoint pump, request_options options) -> boost::future<std::string> {
+        return pump_PIC_version_as<std::string>(pump, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::close_vent_valve_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, idempotent_command, "#{:02d}:00!C875 1\r", pump.get() };
+        co_return deliver<Out>(result<void>{ reply.ec });
+    }
+
+    auto multidrop_network::try_close_vent_valve(multidrop_endpoint pump, request_options options) -> boost::future<result<void>> {
+        return close_vent_valve_as<result<void>>(pump, std::move(options));
     }
 
-    auto multidrop_network::pump_status(multidrop_endpoint pump) -> boost::future<nEXT_status> {
-        auto ec = error_code{};
-        const auto status = co_await pump_status(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
+    auto multidrop_network::close_vent_valve(multidrop_endpoint pump, request_options options) -> boost::future<void> {
+        return close_vent_valve_as<void>(pump, std::move(options));
+    }
+
+    template<typename Out>
+    auto multidrop_network::run_time_as(multidrop_endpoint pump, request_options options, const char * command) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_run_hours>, command, pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
-        co_return status;
+        co_return deliver<Out>(internal::parse_run_hours(internal::view_data(reply)));
     }
 
-    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, error_code & ec) -> boost::future<vent_mode> {
-        const auto response = co_await send_query(ec, "#{:02d}:00?S853\r", pump.get());
-        if (!ec) {
-            const auto data = internal::view_data(response);
-            if (data.size() != 1 || !std::isdigit(data[0])) {
-                ec.assign(boost::system::errc::protocol_error,
-                          boost::system::generic_category());
-            }
-            co_return static_cast<vent_mode>(data[0] - '0');
+    auto multidrop_network::try_controller_run_time(multidrop_endpoint pump, request_options options) -> boost::future<result<run_hours>> {
+        return run_time_as<result<run_hours>>(pump, std::move(options), "#{:02d}:00?V882\r");
+    }
+
+    auto multidrop_network::controller_run_time(multidrop_endpoint pump, request_options options) -> boost::future<run_hours> {
+        return run_time_as<run_hours>(pump, std::move(options), "#{:02d}:00?V882\r");
+    }
+
+    auto multidrop_network::try_pump_run_time(multidrop_endpoint pump, request_options options) -> boost::future<result<run_hours>> {
+        return run_time_as<result<run_hours>>(pump, std::move(options), "#{:02d}:00?V883\r");
+    }
+
+    auto multidrop_network::pump_run_time(multidrop_endpoint pump, request_options options) -> boost::future<run_hours> {
+        return run_time_as<run_hours>(pump, std::move(options), "#{:02d}:00?V883\r");
+    }
+
+    auto multidrop_network::try_bearing_run_time(multidrop_endpoint pump, request_options options) -> boost::future<result<run_hours>> {
+        return run_time_as<result<run_hours>>(pump, std::move(options), "#{:02d}:00?V885\r");
+    }
+
+    auto multidrop_network::bearing_run_time(multidrop_endpoint pump, request_options options) -> boost::future<run_hours> {
+        return run_time_as<run_hours>(pump, std::move(options), "#{:02d}:00?V885\r");
+    }
+
+    template<typename Out>
+    auto multidrop_network::pump_service_status_as(multidrop_endpoint pump, request_options options) -> boost::future<Out> {
+        const auto reply = co_await internal::dialog{ _bus, options, query<internal::parse_service_status>, "#{:02d}:00?V886\r", pump.get() };
+        if (reply.ec) {
+            co_return fail<Out>(reply.ec);
         }
-        co_return vent_mode::_0;
+        co_return deliver<Out>(internal::parse_service_status(internal::view_data(reply)));
+    }
+
+    auto multidrop_network::try_pump_service_status(multidrop_endpoint pump, request_options options) -> boost::future<result<::edwards::service_status>> {
+        return pump_service_status_as<result<::edwards::service_status>>(pump, std::move(options));
+    }
+
+    auto multidrop_network::pump_service_status(multidrop_endpoint pump, request_options options) -> boost::future<::edwards::service_status> {
+        return pump_service_status_as<::edwards::service_status>(pump, std::move(options));
     }
 
-    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump) -> boost::future<vent_mode> {
-        auto ec = error_code{};
-        const auto mode = co_await pump_vent_mode(pump, ec);
-        if (ec) {
-            throw boost::system::system_error{ ec };
+    template<typename Out>
+    auto multidrop_network::send_verified(multidrop_endpoint pump, request_options options, const char * command,
+                                          verifier applied) -> boost::future<Out> {
+        auto reply = co_await internal::dialog{ _bus, options, verified_command, command, pump.get() };
+        for (auto attempts = 1; reply.ec; ++attempts) {
+            const auto backoff = _bus.plan_retry(reply.ec, attempts, options.deadline);
+            if (!backoff) {
+                break;
+            }
+            EDWARDS_TRACE(trace_event::retry, reply.trace_id, pump.get());
+            co_await internal::delay{ _bus.get_io_service(), *backoff };
+
+            // Only the reply may have been lost, in which case the command must not be repeated.  If
+            // the pump cannot be read back either, whether it was carried out stays unknown.
+            const auto check = co_await (this->*applied)(pump, options);
+            if (!check) {
+                co_return fail<Out>(check.error());
+            }
+            if (*check) {
+                co_return deliver<Out>(result<void>{ });
+            }
+            reply = co_await internal::dialog{ _bus, options, verified_command, command, pump.get() };
         }
-        co_return mode;
+        co_return deliver<Out>(result<void>{ reply.ec });
+    }
+
+    // Error code forms
+
+    auto multidrop_network::pump_info(multidrop_endpoint pump, error_code & ec) -> boost::future<::edwards::pump_info> {
+        return assign_error(try_pump_info(pump), ec);
+    }
+
+    auto multidrop_network::start_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
+        return assign_error(try_start_pump(pump), ec);
+    }
+
+    auto multidrop_network::stop_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
+        return assign_error(try_stop_pump(pump), ec);
+    }
+
+    auto multidrop_network::pump_current_speed(multidrop_endpoint pump, error_code & ec) -> boost::future<hertz_t> {
+        return assign_error(try_pump_current_speed(pump), ec);
+    }
+
+    auto multidrop_network::pump_status(multidrop_endpoint pump, error_code & ec) -> boost::future<nEXT_status> {
+        return assign_error(try_pump_status(pump), ec);
+    }
+
+    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, error_code & ec) -> boost::future<vent_mode> {
+        return assign_error(try_pump_vent_mode(pump), ec);
     }
 
     auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode, error_code & ec) -> boost::future<void> {
-        return send_message(ec, "#{:02d}:00!S853 {}\r", pump.get(), static_cast<int>(new_mode));
+        return assign_error(try_pump_vent_mode(pump, new_mode), ec);
     }
 
-    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, vent_mode new_mode) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await pump_vent_mode(pump, new_mode, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
-        }
+    auto multidrop_network::pump_vent_mode(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
+        return assign_error(try_pump_vent_mode(pump, factory_default), ec);
+    }
+
+    auto multidrop_network::pump_timer(multidrop_endpoint pump, error_code & ec) -> boost::future<std::chrono::minutes> {
+        return assign_error(try_pump_timer(pump), ec);
     }
 
     auto multidrop_network::pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout, error_code & ec) -> boost::future<void> {
-        assert(new_timeout >= 1min && new_timeout <= 30min);
+        return assign_error(try_pump_timer(pump, new_timeout), ec);
+    }
 
-        return send_message(ec, "#{:02d}:00!S854 {}\r", pump.get(), new_timeout.count());
+    auto multidrop_network::pump_timer(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
+        return assign_error(try_pump_timer(pump, factory_default), ec);
     }
 
-    auto multidrop_network::pump_timer(multidrop_endpoint pump, std::chrono::minutes new_timeout) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await pump_timer(pump, new_timeout, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
-        }
+    auto multidrop_network::pump_power_limit(multidrop_endpoint pump, error_code & ec) -> boost::future<watt_t> {
+        return assign_error(try_pump_power_limit(pump), ec);
     }
 
     auto multidrop_network::pump_power_limit(multidrop_endpoint pump, watt_t new_limit, error_code & ec) -> boost::future<void> {
-        assert(new_limit >= 50_W && new_limit <= 200_W);
+        return assign_error(try_pump_power_limit(pump, new_limit), ec);
+    }
 
-        return send_message(ec, "#{:02d}:00!S855 {}\r", pump.get(), units::unit_cast<int>(new_limit));
+    auto multidrop_network::pump_power_limit(multidrop_endpoint pump, factory_default_t, error_code & ec) -> boost::future<void> {
+        return assign_error(try_pump_power_limit(pump, factory_default), ec);
     }
 
-    auto multidrop_network::pump_power_limit(multidrop_endpoint pump, watt_t new_limit) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await pump_power_limit(pump, new_limit, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
-        }
+    auto multidrop_network::pump_temp(multidrop_endpoint pump, error_code & ec) -> boost::future<pump_temperature> {
+        return assign_error(try_pump_temp(pump), ec);
     }
 
     auto multidrop_network::factory_reset_pump(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
-        return send_message(ec, "#{:02d}:00!S867 1\r", pump.get());
+        return assign_error(try_factory_reset_pump(pump), ec);
     }
 
-    auto multidrop_network::factory_reset_pump(multidrop_endpoint pump) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await factory_reset_pump(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
-        }
+    auto multidrop_network::pump_PIC_version(multidrop_endpoint pump, error_code & ec) -> boost::future<std::string> {
+        return assign_error(try_pump_PIC_version(pump), ec);
     }
 
     auto multidrop_network::close_vent_valve(multidrop_endpoint pump, error_code & ec) -> boost::future<void> {
-        return send_message(ec, "#{:02d}:00!C875 1\r", pump.get());
+        return assign_error(try_close_vent_valve(pump), ec);
     }
 
-    auto multidrop_network::close_vent_valve(multidrop_endpoint pump) -> boost::future<void> {
-        auto ec = error_code{};
-        co_await close_vent_valve(pump, ec);
-        if (ec) {
-            throw boost::system::error_code{ ec };
+    auto multidrop_network::is_started(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>> {
+        const auto status = co_await try_pump_status(pump, std::move(options));
+        if (!status) {
+            co_return status.error();
         }
+        co_return has_flag(*status, nEXT_status::start);
+    }
+
+    auto multidrop_network::is_stopped(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>> {
+        const auto started = co_await is_started(pump, std::move(options));
+        if (!started) {
+            co_return started.error();
+        }
+        co_return !*started;
+    }
+
+    auto multidrop_network::is_factory_default(multidrop_endpoint pump, request_options options) -> boost::future<result<bool>> {
+        const auto mode = co_await try_pump_vent_mode(pump, options);
+        const auto timer = co_await try_pump_timer(pump, options);
+        const auto limit = co_await try_pump_power_limit(pump, options);
+        if (!mode || !timer || !limit) {
+            co_return !mode ? mode.error() : !timer ? timer.error() : limit.error();
+        }
+        co_return *mode == vent_mode::_0 && *timer == 8min && *limit == 160_W;
+    }
+
+    auto multidrop_network::try_pump_info(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<::edwards::pump_info> {
+        return query_blocking<internal::parse_pump_info>(_bus, options, "#{:02d}:00?S851\r", pump.get());
+    }
+
+    auto multidrop_network::try_start_pump(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<void> {
+        return command_blocking(_bus, options, "#{:02d}:00!C852 1\r", pump.get());
+    }
+
+    auto multidrop_network::try_stop_pump(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<void> {
+        return command_blocking(_bus, options, "#{:02d}:00!C852 0\r", pump.get());
+    }
+
+    auto multidrop_network::try_pump_speed_status(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<::edwards::pump_speed_status> {
+        return query_blocking<internal::parse_speed_status>(_bus, options, "#{:02d}:00?V852\r", pump.get());
+    }
+
+    auto multidrop_network::try_pump_vent_mode(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<vent_mode> {
+        return query_blocking<internal::parse_vent_mode>(_bus, options, "#{:02d}:00?S853\r", pump.get());
+    }
+
+    auto multidrop_network::try_pump_vent_mode(blocking_t, multidrop_endpoint pump, vent_mode new_mode, const request_options & options) -> result<void> {
+        return command_blocking(_bus, options, "#{:02d}:00!S853 {}\r", pump.get(), static_cast<int>(new_mode));
+    }
+
+    auto multidrop_network::try_pump_timer(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<std::chrono::minutes> {
+        const auto minutes = query_blocking<internal::parse_integer>(_bus, options, "#{:02d}:00?S854\r", pump.get());
+        if (!minutes) {
+            return minutes.error();
+        }
+        return std::chrono::minutes{ *minutes };
+    }
+
+    auto multidrop_network::try_pump_timer(blocking_t, multidrop_endpoint pump, std::chrono::minutes new_timeout, const request_options & options) -> result<void> {
+        assert(new_timeout >= 1min && new_timeout <= 30min);
+
+        return command_blocking(_bus, options, "#{:02d}:00!S854 {}\r", pump.get(), new_timeout.count());
+    }
+
+    auto multidrop_network::try_pump_power_limit(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<watt_t> {
+        const auto watts = query_blocking<internal::parse_integer>(_bus, options, "#{:02d}:00?S855\r", pump.get());
+        if (!watts) {
+            return watts.error();
+        }
+        return watt_t{ static_cast<double>(*watts) };
+    }
+
+    auto multidrop_network::try_pump_power_limit(blocking_t, multidrop_endpoint pump, watt_t new_limit, const request_options & options) -> result<void> {
+        assert(new_limit >= 50_W && new_limit <= 200_W);
+
+        return command_blocking(_bus, options, "#{:02d}:00!S855 {}\r", pump.get(), units::unit_cast<int>(new_limit));
+    }
+
+    auto multidrop_network::try_pump_temp(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<pump_temperature> {
+        return query_blocking<internal::parse_temperature>(_bus, options, "#{:02d}:00?V859\r", pump.get());
+    }
+
+    auto multidrop_network::try_pump_service_status(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<::edwards::service_status> {
+        return query_blocking<internal::parse_service_status>(_bus, options, "#{:02d}:00?V886\r", pump.get());
+    }
+
+    auto multidrop_network::try_close_vent_valve(blocking_t, multidrop_endpoint pump, const request_options & options) -> result<void> {
+        return command_blocking(_bus, options, "#{:02d}:00!C875 1\r", pump.get());
     }
-} // namespace edwards
\ No newline at end of file
+} // namespace edwards
@@ -0,0 +1,288 @@
+#include <edwards/reconciler.hpp>
+
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include <common/coroutines.hpp>
+
+namespace edwards {
+    namespace {
+        constexpr auto not_verified = std::numeric_limits<std::size_t>::max();
+
+        // Power limits are set in whole watts
+        auto same_power_limit(watt_t lhs, watt_t rhs) noexcept -> bool {
+            return units::unit_cast<int>(lhs) == units::unit_cast<int>(rhs);
+        }
+
+        /// Calls f(setting, read_ec, matches) for every setting managed by target.
+        template<typename Observed, typename F>
+        auto for_each_setting(const pump_settings & target, const Observed & current, F && f) -> void {
+            if (target.vent) {
+                f(pump_setting::vent_mode, current.vent_ec, current.vent == *target.vent);
+            }
+            if (target.timer) {
+                f(pump_setting::timer, current.timer_ec, current.timer == *target.timer);
+            }
+            if (target.power_limit) {
+                f(pump_setting::power_limit, current.power_limit_ec,
+                  same_power_limit(current.power_limit, *target.power_limit));
+            }
+        }
+
+        auto copy_setting(pump_settings & to, const pump_settings & from, pump_setting setting) -> void {
+            switch (setting) {
+                case pump_setting::vent_mode:
+                    to.vent = from.vent;
+                    break;
+
+                case pump_setting::timer:
+                    to.timer = from.timer;
+                    break;
+
+                case pump_setting::power_limit:
+                    to.power_limit = from.power_limit;
+                    break;
+            }
+        }
+
+        auto write_setting(multidrop_network & network,
+                           multidrop_endpoint pump,
+                           const pump_settings & target,
+                           pump_setting setting) -> boost::future<result<void>> {
+            switch (setting) {
+                case pump_setting::vent_mode:
+                    return network.try_pump_vent_mode(pump, *target.vent);
+
+                case pump_setting::timer:
+                    return network.try_pump_timer(pump, *target.timer);
+
+                case pump_setting::power_limit:
+                    return network.try_pump_power_limit(pump, *target.power_limit);
+            }
+            std::terminate();
+        }
+
+        /// Stores the value of r in value, or its error in ec.
+        template<typename T>
+        auto unpack(const result<T> & r, T & value, error_code & ec) -> void {
+            if (r) {
+                value = *r;
+            }
+            else {
+                ec = r.error();
+            }
+        }
+    }
+
+    configuration_reconciler::configuration_reconciler(multidrop_network & network)
+        : _network{ std::addressof(network) }
+        , _timer{ network.get_io_service() }
+    { }
+
+    auto configuration_reconciler::set_target(multidrop_endpoint pump, const pump_settings & settings) -> void {
+        const auto it = std::find_if(_targets.begin(), _targets.end(),
+                                     [pump](const target & t) { return t.pump.get() == pump.get(); });
+        if (it != _targets.end()) {
+            it->settings = settings;
+        }
+        else {
+            _targets.push_back(target{ pump, settings });
+        }
+    }
+
+    auto configuration_reconciler::clear_target(multidrop_endpoint pump) -> void {
+        _targets.erase(std::remove_if(_targets.begin(), _targets.end(),
+                                      [pump](const target & t) { return t.pump.get() == pump.get(); }),
+                       _targets.end());
+    }
+
+    auto configuration_reconciler::read(std::vector<target> targets, request_options options)
+        -> boost::future<std::vector<observed>>
+    {
+        struct pending {
+            boost::future<result<vent_mode>>            vent;
+            boost::future<result<std::chrono::minutes>> timer;
+            boost::future<result<watt_t>>               power_limit;
+        };
+
+        auto queries = std::vector<pending>(targets.size());
+        for (auto i = std::size_t{ 0 }; i < targets.size(); ++i) {
+            const auto & t = targets[i];
+            auto & q = queries[i];
+
+            if (t.settings.vent) {
+                q.vent = _network->try_pump_vent_mode(t.pump, options);
+            }
+            if (t.settings.timer) {
+                q.timer = _network->try_pump_timer(t.pump, options);
+            }
+            if (t.settings.power_limit) {
+                q.power_limit = _network->try_pump_power_limit(t.pump, options);
+            }
+        }
+
+        auto current = std::vector<observed>(targets.size());
+        for (auto i = std::size_t{ 0 }; i < targets.size(); ++i) {
+            auto & c = current[i];
+            auto & q = queries[i];
+
+            if (q.vent.valid()) {
+                unpack(co_await std::move(q.vent), c.vent, c.vent_ec);
+            }
+            if (q.timer.valid()) {
+                unpack(co_await std::move(q.timer), c.timer, c.timer_ec);
+            }
+            if (q.power_limit.valid()) {
+                unpack(co_await std::move(q.power_limit), c.power_limit, c.power_limit_ec);
+            }
+        }
+
+        co_return current;
+    }
+
+    auto configuration_reconciler::apply() -> boost::future<reconcile_report> {
+        struct pending_write {
+            std::size_t                 target;
+            pump_setting                setting;
+            boost::future<result<void>> done;
+            error_code                  ec;
+        };
+
+        // Take a copy, the targets may be changed while we're suspended.
+        const auto targets = _targets;
+        const auto current = co_await read(targets);
+
+        auto report = reconcile_report{};
+        auto writes = std::vector<pending_write>{};
+
+        for (auto i = std::size_t{ 0 }; i < targets.size(); ++i) {
+            const auto & t = targets[i];
+            for_each_setting(t.settings, current[i], [&](pump_setting setting, const error_code & ec, bool matches) {
+                if (ec) {
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::failed, ec });
+                }
+                else if (matches) {
+                    ++report.in_sync;
+                }
+                else {
+                    writes.push_back(pending_write{ i, setting, write_setting(*_network, t.pump, t.settings, setting), {} });
+                }
+            });
+        }
+
+        // Read back everything that was written successfully
+        auto to_verify = std::vector<target>{};
+        auto verify_index = std::vector<std::size_t>(targets.size(), not_verified);
+        for (auto & w : writes) {
+            w.ec = (co_await std::move(w.done)).error();
+            if (w.ec) {
+                continue;
+            }
+
+            const auto & t = targets[w.target];
+            if (verify_index[w.target] == not_verified) {
+                verify_index[w.target] = to_verify.size();
+                to_verify.push_back(target{ t.pump, pump_settings{} });
+            }
+            copy_setting(to_verify[verify_index[w.target]].settings, t.settings, w.setting);
+        }
+
+        const auto verified = co_await read(to_verify);
+
+        for (const auto & w : writes) {
+            const auto & t = targets[w.target];
+            if (w.ec) {
+                report.changes.push_back(setting_change{ t.pump, w.setting, reconcile_status::failed, w.ec });
+                continue;
+            }
+
+            const auto j = verify_index[w.target];
+            auto only = pump_settings{};
+            copy_setting(only, t.settings, w.setting);
+            for_each_setting(only, verified[j], [&](pump_setting setting, const error_code & ec, bool matches) {
+                if (ec) {
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::failed, ec });
+                }
+                else if (!matches) {
+                    // The pump acknowledged the write but did not store the new value
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::not_applied, {} });
+                }
+                else {
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::written, {} });
+                }
+            });
+        }
+
+        co_return report;
+    }
+
+    auto configuration_reconciler::check_drift(request_options options) -> boost::future<reconcile_report> {
+        const auto targets = _targets;
+        const auto current = co_await read(targets, std::move(options));
+
+        auto report = reconcile_report{};
+        for (auto i = std::size_t{ 0 }; i < targets.size(); ++i) {
+            const auto & t = targets[i];
+            for_each_setting(t.settings, current[i], [&](pump_setting setting, const error_code & ec, bool matches) {
+                if (ec) {
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::failed, ec });
+                }
+                else if (matches) {
+                    ++report.in_sync;
+                }
+                else {
+                    report.changes.push_back(setting_change{ t.pump, setting, reconcile_status::drifted, {} });
+                }
+            });
+        }
+
+        co_return report;
+    }
+
+    auto configuration_reconciler::start_drift_checks(std::chrono::steady_clock::duration interval,
+                                                      drift_handler on_drift) -> void {
+        _drift_interval = interval;
+        _on_drift = std::move(on_drift);
+        if (!_checking) {
+            _checking = true;
+            periodic_check();
+        }
+    }
+
+    auto configuration_reconciler::stop_drift_checks() -> void {
+        _checking = false;
+        _timer.cancel();
+        _cancellation.cancel();
+        _cancellation = cancellation_source{ };
+    }
+
+    auto configuration_reconciler::periodic_check() -> boost::future<void> {
+        // A check not sent by the time the next one is due is superseded by it
+        auto options = within(_drift_interval);
+        options.priority = request_priority::background;
+        options.cancellation = _cancellation;
+
+        const auto report = co_await check_drift(options);
+        if (options.cancellation->is_cancelled()) {
+            co_return;
+        }
+
+        if (!report.changes.empty() && _on_drift) {
+            _on_drift(report);
+        }
+
+        // The next check is timed from the end of this one so checks never overlap.  The handler
+        // may have stopped the checks, and started them again with a new check of its own.
+        if (_checking && !options.cancellation->is_cancelled()) {
+            _timer.expires_from_now(_drift_interval);
+            _timer.async_wait([this](const error_code & ec) {
+                if (!ec) {
+                    periodic_check();
+                }
+            });
+        }
+    }
+} // namespace edwards
@@ -0,0 +1,29 @@
+#include <edwards/request_options.hpp>
+#include <edwards/internal/cancellation_state.hpp>
+#include <edwards/internal/dialog.hpp>
+
+namespace edwards {
+    cancellation_source::cancellation_source()
+        : _state{ std::make_shared<internal::cancellation_state>() }
+    { }
+
+    auto cancellation_source::cancel() noexcept -> void {
+        if (_state->cancelled.exchange(true)) {
+            return;
+        }
+
+        // Dialogs still queued check the flag before they are started.  One already exchanging
+        // messages has to be interrupted on the io thread.
+        if (const auto service = _state->service.load()) {
+            service->post([state = _state] {
+                if (state->active != nullptr) {
+                    state->active->abandon();
+                }
+            });
+        }
+    }
+
+    auto cancellation_source::is_cancelled() const noexcept -> bool {
+        return _state->cancelled.load();
+    }
+} // namespace edwards
@@ -0,0 +1,253 @@
+#include <edwards/shared_state.hpp>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <string>
+
+#if !defined(_WIN32)
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+
+namespace edwards::internal {
+    // Layout of the shared memory segment.  Everything is an address-free atomic so that readers
+    // in other processes never race with the publisher, even while a slot is being rewritten.
+    struct alignas(64) state_slot {
+        // Odd while the slot is being written
+        std::atomic<std::uint32_t> sequence;
+        std::atomic<std::uint32_t> speed;
+        std::atomic<std::uint32_t> status;
+        std::atomic<std::int32_t>  motor_temperature;
+        std::atomic<std::int32_t>  controller_temperature;
+        // Nanoseconds since the system clock epoch, 0 if never published
+        std::atomic<std::int64_t>  status_time;
+        std::atomic<std::int64_t>  temperature_time;
+    };
+
+    struct state_table {
+        static constexpr std::uint32_t magic_value = 0x45445354; // "EDST"
+        static constexpr std::uint32_t version_value = 1;
+
+        std::atomic<std::uint32_t> magic;
+        std::atomic<std::uint32_t> version;
+        // Indexed directly by endpoint, slot 0 and the wildcard are never written
+        state_slot                 slots[100];
+    };
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free &&
+                  std::atomic<std::int64_t>::is_always_lock_free,
+                  "shared state requires address-free atomics");
+} // namespace edwards::internal
+
+namespace edwards {
+#if !defined(_WIN32)
+    namespace {
+        using internal::state_slot;
+        using internal::state_table;
+
+        // Attempts a reader makes at a consistent snapshot before giving up, in case the publisher
+        // died part way through an update
+        constexpr auto max_read_attempts = 1024;
+
+        [[noreturn]] auto throw_errno(const char * what) -> void {
+            throw boost::system::system_error{
+                boost::system::error_code{ errno, boost::system::system_category() }, what };
+        }
+
+        auto now_ns() noexcept -> std::int64_t {
+            using namespace std::chrono;
+            return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+        }
+
+        auto to_time_point(std::int64_t ns) noexcept -> std::chrono::system_clock::time_point {
+            using namespace std::chrono;
+            return system_clock::time_point{ duration_cast<system_clock::duration>(nanoseconds{ ns }) };
+        }
+
+        /// Runs f between the two sequence increments of the slot.  Making the sequence odd claims
+        /// the slot, so concurrent writers to one slot take turns instead of tearing it.
+        template<typename F>
+        auto write_slot(state_slot & slot, F && f) noexcept -> void {
+            auto seq = slot.sequence.load(std::memory_order_relaxed);
+            for (;;) {
+                if (seq & 1) {
+                    // Another writer holds the slot for a few stores
+                    seq = slot.sequence.load(std::memory_order_relaxed);
+                }
+                else if (slot.sequence.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire,
+                                                             std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+            f(slot);
+            slot.sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        auto map_table(std::string_view name, int flags, int prot) -> state_table * {
+            const auto fd = ::shm_open(std::string{ name }.c_str(), flags, 0644);
+            if (fd == -1) {
+                throw_errno("shm_open");
+            }
+
+            if ((flags & O_CREAT) && ::ftruncate(fd, sizeof(state_table)) == -1) {
+                ::close(fd);
+                throw_errno("ftruncate");
+            }
+
+            const auto addr = ::mmap(nullptr, sizeof(state_table), prot, MAP_SHARED, fd, 0);
+            // The mapping keeps the memory alive, the descriptor is no longer needed
+            ::close(fd);
+            if (addr == MAP_FAILED) {
+                throw_errno("mmap");
+            }
+            return static_cast<state_table*>(addr);
+        }
+    }
+
+    state_publisher::state_publisher(std::string_view name)
+        : _table{ map_table(name, O_CREAT | O_RDWR, PROT_READ | PROT_WRITE) }
+    {
+        // A freshly created segment is zero filled, which is a valid table with nothing published.
+        // Stamp it so readers can tell it apart from an unrelated segment.
+        _table->version.store(state_table::version_value, std::memory_order_relaxed);
+        _table->magic.store(state_table::magic_value, std::memory_order_release);
+
+        // A previous publisher may have died part way through an update.  Being the only
+        // publisher, no update is really in progress, so release any slot left claimed.
+        for (auto & slot : _table->slots) {
+            if (const auto seq = slot.sequence.load(std::memory_order_relaxed); seq & 1) {
+                slot.sequence.store(seq + 1, std::memory_order_release);
+            }
+        }
+    }
+
+    state_publisher::~state_publisher() {
+        ::munmap(_table, sizeof(state_table));
+    }
+
+    auto state_publisher::publish_status(multidrop_endpoint pump, hertz_t speed, nEXT_status status) noexcept -> void {
+        const auto time = now_ns();
+        write_slot(_table->slots[pump.get()], [&](state_slot & slot) {
+            slot.speed.store(units::unit_cast<std::uint32_t>(speed), std::memory_order_relaxed);
+            slot.status.store(static_cast<std::uint32_t>(status), std::memory_order_relaxed);
+            slot.status_time.store(time, std::memory_order_relaxed);
+        });
+    }
+
+    auto state_publisher::publish_temperature(multidrop_endpoint pump, const pump_temperature & temperature) noexcept -> void {
+        const auto time = now_ns();
+        write_slot(_table->slots[pump.get()], [&](state_slot & slot) {
+            slot.motor_temperature.store(units::unit_cast<std::int32_t>(temperature.motor), std::memory_order_relaxed);
+            slot.controller_temperature.store(units::unit_cast<std::int32_t>(temperature.controller), std::memory_order_relaxed);
+            slot.temperature_time.store(time, std::memory_order_relaxed);
+        });
+    }
+
+    auto state_publisher::remove(std::string_view name) noexcept -> void {
+        ::shm_unlink(std::string{ name }.c_str());
+    }
+
+    state_reader::state_reader(std::string_view name)
+        : _table{ map_table(name, O_RDONLY, PROT_READ) }
+    {
+        if (_table->magic.load(std::memory_order_acquire) != state_table::magic_value ||
+            _table->version.load(std::memory_order_relaxed) != state_table::version_value) {
+            ::munmap(const_cast<state_table*>(_table), sizeof(state_table));
+            throw boost::system::system_error{
+                boost::system::errc::make_error_code(boost::system::errc::invalid_argument),
+                "state_reader: not a state table" };
+        }
+    }
+
+    state_reader::~state_reader() {
+        ::munmap(const_cast<state_table*>(_table), sizeof(state_table));
+    }
+
+    auto state_reader::read(multidrop_endpoint pump) const noexcept -> std::optional<pump_snapshot> {
+        const auto & slot = _table->slots[pump.get()];
+
+        std::uint32_t speed, status;
+        std::int32_t  motor, controller;
+        std::int64_t  status_time, temperature_time;
+
+        for (auto attempts = 0; ; ++attempts) {
+            if (attempts == max_read_attempts) {
+                return std::nullopt;
+            }
+
+            const auto before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                // Publisher is part way through an update, which only ever takes a few stores
+                continue;
+            }
+
+            speed = slot.speed.load(std::memory_order_relaxed);
+            status = slot.status.load(std::memory_order_relaxed);
+            motor = slot.motor_temperature.load(std::memory_order_relaxed);
+            controller = slot.controller_temperature.load(std::memory_order_relaxed);
+            status_time = slot.status_time.load(std::memory_order_relaxed);
+            temperature_time = slot.temperature_time.load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                break;
+            }
+        }
+
+        if (status_time == 0 && temperature_time == 0) {
+            return std::nullopt;
+        }
+
+        return pump_snapshot{
+            hertz_t{ static_cast<double>(speed) },
+            static_cast<nEXT_status>(status),
+            to_time_point(status_time),
+            pump_temperature{ celsius_t{ static_cast<double>(motor) },
+                              celsius_t{ static_cast<double>(controller) } },
+            to_time_point(temperature_time)
+        };
+    }
+#else
+    namespace {
+        [[noreturn]] auto throw_not_supported(const char * what) -> void {
+            throw boost::system::system_error{
+                boost::system::errc::make_error_code(boost::system::errc::operation_not_supported), what };
+        }
+    }
+
+    // POSIX shared memory is not available, a publisher can never be created.  The members still
+    // exist so that multidrop_network links everywhere.
+    state_publisher::state_publisher(std::string_view)
+        : _table{ nullptr }
+    {
+        throw_not_supported("state_publisher");
+    }
+
+    state_publisher::~state_publisher() = default;
+
+    auto state_publisher::publish_status(multidrop_endpoint, hertz_t, nEXT_status) noexcept -> void { }
+
+    auto state_publisher::publish_temperature(multidrop_endpoint, const pump_temperature &) noexcept -> void { }
+
+    auto state_publisher::remove(std::string_view) noexcept -> void { }
+
+    state_reader::state_reader(std::string_view)
+        : _table{ nullptr }
+    {
+        throw_not_supported("state_reader");
+    }
+
+    state_reader::~state_reader() = default;
+
+    auto state_reader::read(multidrop_endpoint) const noexcept -> std::optional<pump_snapshot> {
+        return std::nullopt;
+    }
+#endif
+} // namespace edwards
@@ -0,0 +1,682 @@
+#include <edwards/telemetry_store.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <boost/system/error_code.hpp>
+#include <boost/system/system_error.hpp>
+
+namespace edwards::internal {
+    /// Start of every segment, recording how much of it holds complete blocks so that a
+    /// file-backed segment can be read back after a restart.
+    struct segment_header {
+        static constexpr std::uint32_t magic_value = 0x45445453; // "EDTS"
+        static constexpr std::uint32_t version_value = 1;
+
+        std::uint32_t magic;
+        std::uint32_t version;
+        // Resolution of the timestamps in the segment, in milliseconds
+        std::int64_t  resolution;
+        // Bytes of blocks following the header
+        std::uint64_t used;
+    };
+
+    /// A fixed-size region of memory-mapped storage which compressed blocks are appended to.
+    class telemetry_segment {
+    public:
+        /// Creates a new segment, backed by a file in directory unless it is empty.
+        telemetry_segment(const std::string & directory, std::uint64_t id, std::size_t size,
+                          std::chrono::milliseconds resolution)
+            : _size{ size }
+        {
+            auto fd = -1;
+            if (!directory.empty()) {
+                _path = path(directory, id);
+                // Never reuse an existing file, it holds history recovered by another store
+                fd = ::open(_path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+                if (fd == -1) {
+                    throw_errno("open");
+                }
+                if (::ftruncate(fd, static_cast<off_t>(size)) == -1) {
+                    ::close(fd);
+                    ::unlink(_path.c_str());
+                    throw_errno("ftruncate");
+                }
+            }
+
+            map(fd);
+            header() = segment_header{ segment_header::magic_value, segment_header::version_value,
+                                       resolution.count(), 0 };
+        }
+
+        /// Opens the existing segment at path, written with the given timestamp resolution.
+        telemetry_segment(std::string path, std::chrono::milliseconds resolution)
+            : _path{ std::move(path) }
+        {
+            const auto fd = ::open(_path.c_str(), O_RDWR);
+            if (fd == -1) {
+                throw_errno("open");
+            }
+            struct stat st;
+            if (::fstat(fd, &st) == -1) {
+                ::close(fd);
+                throw_errno("fstat");
+            }
+            _size = static_cast<std::size_t>(st.st_size);
+            if (_size < sizeof(segment_header)) {
+                ::close(fd);
+                throw_invalid("telemetry_segment: truncated segment");
+            }
+            map(fd);
+
+            const auto & h = header();
+            if (h.magic != segment_header::magic_value || h.version != segment_header::version_value ||
+                h.used > _size - sizeof(segment_header)) {
+                ::munmap(_data, _size);
+                throw_invalid("telemetry_segment: not a telemetry segment");
+            }
+            if (h.resolution != resolution.count()) {
+                ::munmap(_data, _size);
+                throw_invalid("telemetry_segment: written with a different resolution");
+            }
+        }
+
+        ~telemetry_segment() {
+            ::munmap(_data, _size);
+        }
+
+        telemetry_segment(const telemetry_segment &) = delete;
+        telemetry_segment & operator=(const telemetry_segment &) = delete;
+
+        static auto path(const std::string & directory, std::uint64_t id) -> std::string {
+            return directory + "/telemetry-" + std::to_string(id) + ".seg";
+        }
+
+        auto data() const noexcept -> unsigned char * {
+            return _data;
+        }
+
+        /// Bytes of complete blocks in the segment.
+        auto used() const noexcept -> std::size_t {
+            return static_cast<std::size_t>(header().used);
+        }
+
+        auto available() const noexcept -> std::size_t {
+            return _size - sizeof(segment_header) - used();
+        }
+
+        /// Offset at which the next block is to be written.
+        auto end() const noexcept -> std::size_t {
+            return sizeof(segment_header) + used();
+        }
+
+        /// Adds bytes written at end() to the segment, only then are they read back on recovery.
+        auto commit(std::size_t bytes) noexcept -> void {
+            assert(bytes <= available());
+            header().used += bytes;
+        }
+
+        /// Deletes the backing file, if any.  The mapping stays valid until destruction.
+        auto discard() noexcept -> void {
+            if (!_path.empty()) {
+                ::unlink(_path.c_str());
+            }
+        }
+
+    private:
+        auto map(int fd) -> void {
+            const auto flags = fd == -1 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED;
+            const auto addr = ::mmap(nullptr, _size, PROT_READ | PROT_WRITE, flags, fd, 0);
+            if (fd != -1) {
+                ::close(fd);
+            }
+            if (addr == MAP_FAILED) {
+                throw_errno("mmap");
+            }
+            _data = static_cast<unsigned char*>(addr);
+        }
+
+        auto header() const noexcept -> segment_header & {
+            return *reinterpret_cast<segment_header*>(_data);
+        }
+
+        [[noreturn]] static auto throw_errno(const char * what) -> void {
+            throw boost::system::system_error{
+                boost::system::error_code{ errno, boost::system::system_category() }, what };
+        }
+
+        [[noreturn]] static auto throw_invalid(const char * what) -> void {
+            throw boost::system::system_error{
+                boost::system::errc::make_error_code(boost::system::errc::invalid_argument), what };
+        }
+
+        unsigned char * _data = nullptr;
+        std::size_t     _size;
+        std::string     _path;
+    };
+} // namespace edwards::internal
+
+namespace edwards {
+    namespace {
+        constexpr auto column_count = std::size_t{ 5 };
+
+        // Blocks carry their pump and time range so the index can be rebuilt from the segments
+        struct block_header {
+            std::int64_t  first_time;
+            std::int64_t  last_time;
+            std::uint32_t count;
+            std::uint32_t pump;
+            std::uint32_t column_size[column_count];
+        };
+
+        auto block_size(const block_header & header) noexcept -> std::size_t {
+            auto size = sizeof(block_header);
+            for (const auto column : header.column_size) {
+                size += column;
+            }
+            return size;
+        }
+
+        /// Parses the id out of a segment file name, "telemetry-<id>.seg".
+        auto parse_segment_id(std::string_view name) noexcept -> std::optional<std::uint64_t> {
+            constexpr auto prefix = std::string_view{ "telemetry-" };
+            constexpr auto suffix = std::string_view{ ".seg" };
+            if (name.size() <= prefix.size() + suffix.size() ||
+                name.substr(0, prefix.size()) != prefix ||
+                name.substr(name.size() - suffix.size()) != suffix) {
+                return std::nullopt;
+            }
+
+            const auto digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+            auto id = std::uint64_t{ 0 };
+            for (const auto c : digits) {
+                if (c < '0' || c > '9') {
+                    return std::nullopt;
+                }
+                id = id * 10 + static_cast<std::uint64_t>(c - '0');
+            }
+            return id;
+        }
+
+        constexpr auto zigzag(std::int64_t v) noexcept -> std::uint64_t {
+            return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+        }
+
+        constexpr auto unzigzag(std::uint64_t v) noexcept -> std::int64_t {
+            return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+        }
+
+        /// Writes unsigned values as LEB128 varints, collapsing each run of zeros into a zero
+        /// followed by the length of the run.
+        class column_writer {
+        public:
+            explicit column_writer(std::vector<unsigned char> & out) noexcept
+                : _out{ out }
+                , _start{ out.size() }
+            { }
+
+            auto put(std::uint64_t v) -> void {
+                if (v == 0) {
+                    ++_zeros;
+                    return;
+                }
+                flush_zeros();
+                put_varint(v);
+            }
+
+            /// Finishes the column and returns its size in bytes.
+            auto finish() -> std::uint32_t {
+                flush_zeros();
+                return static_cast<std::uint32_t>(_out.size() - _start);
+            }
+
+        private:
+            auto flush_zeros() -> void {
+                if (_zeros != 0) {
+                    put_varint(0);
+                    put_varint(_zeros);
+                    _zeros = 0;
+                }
+            }
+
+            auto put_varint(std::uint64_t v) -> void {
+                while (v >= 0x80) {
+                    _out.push_back(static_cast<unsigned char>(v | 0x80));
+                    v >>= 7;
+                }
+                _out.push_back(static_cast<unsigned char>(v));
+            }
+
+            std::vector<unsigned char> & _out;
+            std::size_t                  _start;
+            std::uint64_t                _zeros = 0;
+        };
+
+        class column_reader {
+        public:
+            explicit column_reader(const unsigned char * data) noexcept
+                : _next{ data }
+            { }
+
+            auto get() noexcept -> std::uint64_t {
+                if (_zeros != 0) {
+                    --_zeros;
+                    return 0;
+                }
+                const auto v = get_varint();
+                if (v == 0) {
+                    _zeros = get_varint() - 1;
+                }
+                return v;
+            }
+
+        private:
+            auto get_varint() noexcept -> std::uint64_t {
+                auto v = std::uint64_t{ 0 };
+                for (auto shift = 0; ; shift += 7) {
+                    const auto byte = *_next++;
+                    v |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        return v;
+                    }
+                }
+            }
+
+            const unsigned char * _next;
+            std::uint64_t         _zeros = 0;
+        };
+    }
+
+    auto make_telemetry_sample(std::chrono::system_clock::time_point time,
+                               hertz_t speed,
+                               nEXT_status status,
+                               const pump_temperature & temperature) noexcept -> telemetry_sample {
+        return telemetry_sample{
+            time,
+            units::unit_cast<std::uint32_t>(speed),
+            status,
+            units::unit_cast<std::int16_t>(temperature.motor),
+            units::unit_cast<std::int16_t>(temperature.controller)
+        };
+    }
+
+    telemetry_store::telemetry_store()
+        : telemetry_store{ options{} }
+    { }
+
+    telemetry_store::telemetry_store(options opts)
+        : _options{ std::move(opts) }
+    {
+        // A full chunk of incompressible samples must always fit in one segment
+        assert(_options.segment_size >= 64 * 1024);
+        assert(_options.resolution.count() > 0);
+
+        if (!_options.directory.empty()) {
+            lock_directory();
+            try {
+                recover();
+            }
+            catch (...) {
+                ::close(_lock);
+                throw;
+            }
+        }
+    }
+
+    telemetry_store::~telemetry_store() {
+        // Keep the samples not yet compressed with the rest of the history
+        if (!_options.directory.empty()) {
+            try {
+                for (auto & h : _histories) {
+                    if (h.head && h.head->size != 0) {
+                        seal(h);
+                    }
+                }
+            }
+            catch (...) {
+                // Out of space for a new segment, only these samples are lost
+            }
+            ::close(_lock);
+        }
+    }
+
+    auto telemetry_store::lock_directory() -> void {
+        const auto path = _options.directory + "/telemetry.lock";
+        _lock = ::open(path.c_str(), O_CREAT | O_RDWR, 0644);
+        if (_lock == -1) {
+            throw boost::system::system_error{
+                boost::system::error_code{ errno, boost::system::system_category() }, "open" };
+        }
+        if (::flock(_lock, LOCK_EX | LOCK_NB) == -1) {
+            const auto ec = boost::system::error_code{ errno, boost::system::system_category() };
+            ::close(_lock);
+            throw boost::system::system_error{ ec, "telemetry_store: directory in use by another store" };
+        }
+    }
+
+    auto telemetry_store::recover() -> void {
+        auto ids = std::vector<std::uint64_t>{};
+        if (const auto dir = ::opendir(_options.directory.c_str())) {
+            while (const auto entry = ::readdir(dir)) {
+                if (const auto id = parse_segment_id(entry->d_name)) {
+                    ids.push_back(*id);
+                }
+            }
+            ::closedir(dir);
+        }
+        else {
+            throw boost::system::system_error{
+                boost::system::error_code{ errno, boost::system::system_category() }, "opendir" };
+        }
+        if (ids.empty()) {
+            return;
+        }
+
+        // Segments are numbered consecutively, anything before a gap was dropped and is ignored
+        std::sort(ids.begin(), ids.end());
+        auto first = ids.end() - 1;
+        while (first != ids.begin() && *(first - 1) == *first - 1) {
+            --first;
+        }
+        if (_options.max_segments != 0 && static_cast<std::size_t>(ids.end() - first) > _options.max_segments) {
+            first = ids.end() - static_cast<std::ptrdiff_t>(_options.max_segments);
+        }
+        for (auto id = ids.begin(); id != first; ++id) {
+            ::unlink(internal::telemetry_segment::path(_options.directory, *id).c_str());
+        }
+
+        _first_segment = *first;
+        for (auto id = first; id != ids.end(); ++id) {
+            _segments.push_back(std::make_unique<internal::telemetry_segment>(
+                internal::telemetry_segment::path(_options.directory, *id), _options.resolution));
+
+            // Rebuild the index from the block headers
+            const auto & segment = *_segments.back();
+            for (auto offset = sizeof(internal::segment_header); offset < segment.end(); ) {
+                auto header = block_header{};
+                std::memcpy(&header, segment.data() + offset, sizeof(header));
+                if (header.pump >= _histories.size() || header.count == 0 ||
+                    offset + block_size(header) > segment.end()) {
+                    break;
+                }
+                _histories[header.pump].blocks.push_back(block_ref{ *id, offset, header.first_time, header.last_time });
+                offset += block_size(header);
+            }
+            _compressed_size += segment.used();
+        }
+    }
+
+    auto telemetry_store::to_ticks(std::chrono::system_clock::time_point time) const noexcept -> std::int64_t {
+        using namespace std::chrono;
+        return duration_cast<milliseconds>(time.time_since_epoch()).count() / _options.resolution.count();
+    }
+
+    auto telemetry_store::from_ticks(std::int64_t ticks) const noexcept -> std::chrono::system_clock::time_point {
+        using namespace std::chrono;
+        return system_clock::time_point{ duration_cast<system_clock::duration>(_options.resolution * ticks) };
+    }
+
+    auto telemetry_store::append(multidrop_endpoint pump, const telemetry_sample & sample) -> void {
+        auto & h = _histories[pump.get()];
+        if (!h.head) {
+            h.head = std::make_unique<chunk>();
+        }
+
+        auto & c = *h.head;
+        const auto i = c.size++;
+        c.time[i] = to_ticks(sample.time);
+        c.speed[i] = sample.speed;
+        c.status[i] = static_cast<std::uint32_t>(sample.status);
+        c.motor_temperature[i] = sample.motor_temperature;
+        c.controller_temperature[i] = sample.controller_temperature;
+
+        if (c.size == chunk_capacity) {
+            seal(h);
+        }
+    }
+
+    auto telemetry_store::seal(history & h) -> void {
+        const auto & c = *h.head;
+        assert(c.size > 0);
+
+        auto header = block_header{ c.time[0], c.time[c.size - 1], static_cast<std::uint32_t>(c.size),
+                                    static_cast<std::uint32_t>(&h - _histories.data()), {} };
+
+        _scratch.assign(sizeof(block_header), 0);
+        {
+            auto col = column_writer{ _scratch };
+            auto prev_delta = std::int64_t{ 0 };
+            for (auto i = std::size_t{ 1 }; i < c.size; ++i) {
+                const auto delta = c.time[i] - c.time[i - 1];
+                col.put(zigzag(delta - prev_delta));
+                prev_delta = delta;
+            }
+            header.column_size[0] = col.finish();
+        }
+        {
+            auto col = column_writer{ _scratch };
+            auto prev = std::int64_t{ 0 };
+            for (auto i = std::size_t{ 0 }; i < c.size; ++i) {
+                col.put(zigzag(static_cast<std::int64_t>(c.speed[i]) - prev));
+                prev = c.speed[i];
+            }
+            header.column_size[1] = col.finish();
+        }
+        {
+            auto col = column_writer{ _scratch };
+            auto prev = std::uint32_t{ 0 };
+            for (auto i = std::size_t{ 0 }; i < c.size; ++i) {
+                col.put(c.status[i] ^ prev);
+                prev = c.status[i];
+            }
+            header.column_size[2] = col.finish();
+        }
+        const auto write_temperature = [&](const auto & temperatures) {
+            auto col = column_writer{ _scratch };
+            auto prev = std::int64_t{ 0 };
+            for (auto i = std::size_t{ 0 }; i < c.size; ++i) {
+                col.put(zigzag(temperatures[i] - prev));
+                prev = temperatures[i];
+            }
+            return col.finish();
+        };
+        header.column_size[3] = write_temperature(c.motor_temperature);
+        header.column_size[4] = write_temperature(c.controller_temperature);
+        std::memcpy(_scratch.data(), &header, sizeof(header));
+
+        auto ref = allocate(_scratch.size());
+        ref.first_time = c.time[0];
+        ref.last_time = c.time[c.size - 1];
+        std::memcpy(_segments.back()->data() + ref.offset, _scratch.data(), _scratch.size());
+        _segments.back()->commit(_scratch.size());
+        _compressed_size += _scratch.size();
+
+        h.blocks.push_back(ref);
+        h.head->size = 0;
+    }
+
+    auto telemetry_store::allocate(std::size_t bytes) -> block_ref {
+        if (_segments.empty() || _segments.back()->available() < bytes) {
+            if (_options.max_segments != 0 && _segments.size() == _options.max_segments) {
+                drop_oldest_segment();
+            }
+            const auto id = _first_segment + _segments.size();
+            _segments.push_back(std::make_unique<internal::telemetry_segment>(
+                _options.directory, id, _options.segment_size, _options.resolution));
+        }
+
+        const auto id = _first_segment + _segments.size() - 1;
+        return block_ref{ id, _segments.back()->end(), 0, 0 };
+    }
+
+    auto telemetry_store::drop_oldest_segment() -> void {
+        // Blocks are appended in time order, so any block in the oldest segment is at the front
+        // of its pump's history.
+        for (auto & h : _histories) {
+            while (!h.blocks.empty() && h.blocks.front().segment == _first_segment) {
+                h.blocks.pop_front();
+            }
+        }
+        _compressed_size -= _segments.front()->used();
+        _segments.front()->discard();
+        _segments.pop_front();
+        ++_first_segment;
+    }
+
+    auto telemetry_store::segment_data(std::uint64_t id) const noexcept -> const unsigned char * {
+        return _segments[id - _first_segment]->data();
+    }
+
+    template<typename F>
+    auto telemetry_store::for_each_chunk(multidrop_endpoint pump, std::int64_t from, std::int64_t to, F && f) const -> void {
+        const auto & h = _histories[pump.get()];
+
+        auto block = std::lower_bound(h.blocks.begin(), h.blocks.end(), from,
+                                      [](const block_ref & b, std::int64_t t) { return b.last_time < t; });
+        if (block != h.blocks.end() && block->first_time < to) {
+            auto c = std::make_unique<chunk>();
+            for (; block != h.blocks.end() && block->first_time < to; ++block) {
+                const auto data = segment_data(block->segment) + block->offset;
+                auto header = block_header{};
+                std::memcpy(&header, data, sizeof(header));
+
+                c->size = header.count;
+                auto column = data + sizeof(header);
+                {
+                    auto col = column_reader{ column };
+                    auto delta = std::int64_t{ 0 };
+                    c->time[0] = header.first_time;
+                    for (auto i = std::size_t{ 1 }; i < c->size; ++i) {
+                        delta += unzigzag(col.get());
+                        c->time[i] = c->time[i - 1] + delta;
+                    }
+                    column += header.column_size[0];
+                }
+                {
+                    auto col = column_reader{ column };
+                    auto prev = std::int64_t{ 0 };
+                    for (auto i = std::size_t{ 0 }; i < c->size; ++i) {
+                        prev += unzigzag(col.get());
+                        c->speed[i] = static_cast<std::uint32_t>(prev);
+                    }
+                    column += header.column_size[1];
+                }
+                {
+                    auto col = column_reader{ column };
+                    auto prev = std::uint32_t{ 0 };
+                    for (auto i = std::size_t{ 0 }; i < c->size; ++i) {
+                        prev ^= static_cast<std::uint32_t>(col.get());
+                        c->status[i] = prev;
+                    }
+                    column += header.column_size[2];
+                }
+                const auto read_temperature = [&](auto & temperatures, std::uint32_t column_size) {
+                    auto col = column_reader{ column };
+                    auto prev = std::int64_t{ 0 };
+                    for (auto i = std::size_t{ 0 }; i < c->size; ++i) {
+                        prev += unzigzag(col.get());
+                        temperatures[i] = static_cast<std::int16_t>(prev);
+                    }
+                    column += column_size;
+                };
+                read_temperature(c->motor_temperature, header.column_size[3]);
+                read_temperature(c->controller_temperature, header.column_size[4]);
+
+                f(*c);
+            }
+        }
+
+        if (h.head && h.head->size != 0 && h.head->time[0] < to) {
+            f(*h.head);
+        }
+    }
+
+    auto telemetry_store::query(multidrop_endpoint pump,
+                                std::chrono::system_clock::time_point from,
+                                std::chrono::system_clock::time_point to) const -> telemetry_series {
+        const auto first = to_ticks(from);
+        const auto last = to_ticks(to);
+
+        auto series = telemetry_series{};
+        for_each_chunk(pump, first, last, [&](const chunk & c) {
+            const auto begin = std::lower_bound(c.time.begin(), c.time.begin() + c.size, first) - c.time.begin();
+            const auto end = std::lower_bound(c.time.begin() + begin, c.time.begin() + c.size, last) - c.time.begin();
+            for (auto i = begin; i < end; ++i) {
+                series.time.push_back(from_ticks(c.time[i]));
+                series.speed.push_back(c.speed[i]);
+                series.status.push_back(static_cast<nEXT_status>(c.status[i]));
+                series.motor_temperature.push_back(c.motor_temperature[i]);
+                series.controller_temperature.push_back(c.controller_temperature[i]);
+            }
+        });
+        return series;
+    }
+
+    auto telemetry_store::downsample(multidrop_endpoint pump,
+                                     std::chrono::system_clock::time_point from,
+                                     std::chrono::system_clock::time_point to,
+                                     std::chrono::milliseconds interval) const -> std::vector<telemetry_bucket> {
+        assert(interval >= _options.resolution);
+
+        const auto first = to_ticks(from);
+        const auto last = to_ticks(to);
+        const auto width = interval.count() / _options.resolution.count();
+
+        auto buckets = std::vector<telemetry_bucket>{};
+        auto index = std::numeric_limits<std::int64_t>::min();
+        auto speed_sum = std::uint64_t{ 0 };
+
+        const auto close_bucket = [&] {
+            if (!buckets.empty()) {
+                buckets.back().mean_speed = static_cast<double>(speed_sum) / buckets.back().count;
+            }
+        };
+
+        for_each_chunk(pump, first, last, [&](const chunk & c) {
+            const auto begin = std::lower_bound(c.time.begin(), c.time.begin() + c.size, first) - c.time.begin();
+            for (auto i = begin; i < static_cast<std::ptrdiff_t>(c.size) && c.time[i] < last; ++i) {
+                if (const auto b = (c.time[i] - first) / width; b != index) {
+                    close_bucket();
+                    index = b;
+                    speed_sum = 0;
+                    buckets.push_back(telemetry_bucket{
+                        from_ticks(first + b * width), 0,
+                        std::numeric_limits<std::uint32_t>::max(), 0, 0.0,
+                        nEXT_status{ 0 },
+                        std::numeric_limits<std::int16_t>::min(),
+                        std::numeric_limits<std::int16_t>::min() });
+                }
+
+                auto & bucket = buckets.back();
+                ++bucket.count;
+                speed_sum += c.speed[i];
+                bucket.min_speed = std::min(bucket.min_speed, c.speed[i]);
+                bucket.max_speed = std::max(bucket.max_speed, c.speed[i]);
+                bucket.any_status = static_cast<nEXT_status>(static_cast<std::uint32_t>(bucket.any_status) | c.status[i]);
+                bucket.max_motor_temperature = std::max(bucket.max_motor_temperature, c.motor_temperature[i]);
+                bucket.max_controller_temperature = std::max(bucket.max_controller_temperature, c.controller_temperature[i]);
+            }
+        });
+        close_bucket();
+
+        return buckets;
+    }
+
+    auto telemetry_store::compressed_size() const noexcept -> std::size_t {
+        return _compressed_size;
+    }
+} // namespace edwards
@@ -0,0 +1,195 @@
+#include <edwards/trace.hpp>
+#include <edwards/internal/trace.hpp>
+
+#if EDWARDS_ENABLE_TRACING
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <functional>
+#   include <thread>
+#   if defined(__linux__)
+#       include <sys/syscall.h>
+#       include <unistd.h>
+#   endif
+#endif
+
+namespace edwards {
+    namespace internal {
+        namespace {
+            /// Every ring ever created.  The ring of a thread which has exited is kept, with its
+            /// events, until another thread takes it over, so there are only ever as many rings as
+            /// the most threads which have been recording at once.
+            struct trace_registry {
+                std::mutex                               mutex;
+                std::vector<std::unique_ptr<trace_ring>> rings;
+                // Rings whose thread has exited
+                std::vector<trace_ring*>                 unused;
+                // Reference point for converting ticks to time
+                std::uint64_t                            start_ticks = trace_ticks();
+                std::chrono::steady_clock::time_point    start_time = std::chrono::steady_clock::now();
+            };
+
+            auto registry() -> trace_registry & {
+                static auto instance = trace_registry{ };
+                return instance;
+            }
+
+            std::atomic<std::uint32_t> last_trace_id{ 0 };
+
+            /// Id of the calling thread as the operating system reports it, so the exported tracks
+            /// match those of other profilers.
+            auto current_thread_id() noexcept -> std::uint32_t {
+#if defined(_WIN32)
+                return static_cast<std::uint32_t>(::GetCurrentThreadId());
+#elif defined(__linux__)
+                return static_cast<std::uint32_t>(::syscall(SYS_gettid));
+#else
+                return static_cast<std::uint32_t>(std::hash<std::thread::id>{ }(std::this_thread::get_id()));
+#endif
+            }
+
+            /// Holds a ring for the lifetime of a thread.
+            class ring_lease {
+            public:
+                ring_lease() {
+                    auto & reg = registry();
+                    const auto lock = std::lock_guard<std::mutex>{ reg.mutex };
+                    if (reg.unused.empty()) {
+                        reg.rings.push_back(std::make_unique<trace_ring>());
+                        _ring = reg.rings.back().get();
+                    }
+                    else {
+                        _ring = reg.unused.back();
+                        reg.unused.pop_back();
+                    }
+                    _ring->thread = current_thread_id();
+                }
+
+                ~ring_lease() {
+                    auto & reg = registry();
+                    const auto lock = std::lock_guard<std::mutex>{ reg.mutex };
+                    reg.unused.push_back(_ring);
+                }
+
+                ring_lease(const ring_lease &) = delete;
+                ring_lease & operator=(const ring_lease &) = delete;
+
+                auto ring() const noexcept -> trace_ring & {
+                    return *_ring;
+                }
+
+            private:
+                trace_ring * _ring;
+            };
+        }
+
+        auto this_thread_trace_ring() -> trace_ring & {
+            thread_local auto lease = ring_lease{ };
+            return lease.ring();
+        }
+
+        auto next_trace_id() noexcept -> std::uint32_t {
+            return last_trace_id.fetch_add(1, std::memory_order_relaxed) + 1;
+        }
+    } // namespace internal
+
+    namespace {
+        auto event_name(trace_event event) noexcept -> const char * {
+            switch (event) {
+                case trace_event::enqueue:     return "enqueue";
+                case trace_event::write_start: return "write_start";
+                case trace_event::write_end:   return "write_end";
+                case trace_event::first_byte:  return "first_byte";
+                case trace_event::complete:    return "complete";
+                case trace_event::timeout:     return "timeout";
+                case trace_event::retry:       return "retry";
+            }
+            return "unknown";
+        }
+    }
+
+    auto export_chrome_trace(std::ostream & out) -> void {
+        auto & reg = internal::registry();
+
+        auto records = std::vector<internal::trace_record>{ };
+        auto ticks_per_us = 1.0;
+        {
+            const auto lock = std::lock_guard<std::mutex>{ reg.mutex };
+            for (const auto & ring : reg.rings) {
+                const auto head = ring->head.load(std::memory_order_acquire);
+                const auto first = head > internal::trace_ring::capacity ? head - internal::trace_ring::capacity : 0;
+                for (auto i = first; i < head; ++i) {
+                    records.push_back(ring->records[i & (internal::trace_ring::capacity - 1)]);
+                }
+            }
+
+            const auto elapsed_us = std::chrono::duration<double, std::micro>{ std::chrono::steady_clock::now() - reg.start_time }.count();
+            if (elapsed_us > 0) {
+                ticks_per_us = static_cast<double>(internal::trace_ticks() - reg.start_ticks) / elapsed_us;
+            }
+        }
+
+        std::sort(records.begin(), records.end(), [](const internal::trace_record & lhs, const internal::trace_record & rhs) {
+            return lhs.ticks < rhs.ticks;
+        });
+
+        // Async events are matched on name, only the enqueue record carries the command
+        auto names = std::unordered_map<std::uint32_t, std::string>{ };
+
+        out << "{\"traceEvents\":[";
+        auto separator = "";
+        for (const auto & r : records) {
+            if (r.event == trace_event::enqueue) {
+                names[r.dialog] = std::string{ r.command.data() };
+            }
+            const auto name = names.count(r.dialog) ? names[r.dialog] : std::string{ "dialog" };
+
+            const auto phase = r.event == trace_event::enqueue ? 'b' :
+                               r.event == trace_event::complete ? 'e' : 'n';
+            const auto ts = static_cast<double>(r.ticks - reg.start_ticks) / ticks_per_us;
+
+            out << separator
+                << fmt::format("{{\"name\":\"{}\",\"cat\":\"bus\",\"ph\":\"{}\",\"id\":{},\"ts\":{:.3f},\"pid\":1,\"tid\":{},"
+                               "\"args\":{{\"event\":\"{}\",\"endpoint\":{}}}}}",
+                               phase == 'n' ? event_name(r.event) : name.c_str(), phase, r.dialog, ts, r.thread,
+                               event_name(r.event), r.endpoint);
+            separator = ",";
+
+            if (r.event == trace_event::complete) {
+                names.erase(r.dialog);
+            }
+        }
+        out << "],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    auto clear_trace() noexcept -> void {
+        auto & reg = internal::registry();
+        const auto lock = std::lock_guard<std::mutex>{ reg.mutex };
+        for (auto & ring : reg.rings) {
+            ring->head.store(0, std::memory_order_relaxed);
+        }
+    }
+} // namespace edwards
+
+#else
+
+namespace edwards {
+    auto export_chrome_trace(std::ostream & out) -> void {
+        out << "{\"traceEvents\":[]}\n";
+    }
+
+    auto clear_trace() noexcept -> void { }
+} // namespace edwards
+
+#endif
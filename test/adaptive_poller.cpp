@@ -0,0 +1,89 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/adaptive_poller.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+#include <catch.hpp>
+
+#include "fake_device.hpp"
+
+using namespace edwards;
+using namespace std::chrono_literals;
+
+namespace {
+    using periods = std::vector<std::chrono::milliseconds>;
+
+    /// Polls a pump which answers ?V852 with each of replies in turn, repeating the last, and
+    /// returns the period the poller chose after each of the first count samples.  An empty reply
+    /// leaves the poll unanswered.
+    auto poll_periods(const std::vector<std::string> & replies, std::size_t count) -> periods {
+        auto next = std::atomic<std::size_t>{ 0 };
+        auto device = test::fake_device{ [&](std::string_view request) {
+            const auto & data = replies[std::min(next++, replies.size() - 1)];
+            return data.empty() ? std::string{ } : test::reply_to(request, data);
+        } };
+
+        auto service = boost::asio::io_service{ };
+        auto network = multidrop_network{ service, device.path() };
+
+        auto options = adaptive_poller::options{ };
+        options.fastest = 20ms;
+        options.slowest = 160ms;
+        options.speed_threshold = hertz_t{ 5 };
+
+        auto result = periods{ };
+        adaptive_poller * poller = nullptr;
+        auto p = adaptive_poller{ network, options, [&](const poll_sample & s) {
+            result.push_back(s.next_period);
+            if (result.size() == count) {
+                poller->stop();
+            }
+        } };
+        poller = &p;
+
+        p.add(multidrop_endpoint{ 1 });
+        p.start();
+        service.run();
+        return result;
+    }
+}
+
+TEST_CASE("adaptive_poller backs off a steady pump to the slowest period", "[adaptive_poller]") {
+    // The first sample counts as a change, there is nothing to compare it with
+    CHECK(poll_periods({ "1500;0004" }, 5) == periods{ 20ms, 40ms, 80ms, 160ms, 160ms });
+
+    // Stopped, with the vent valve open for good
+    CHECK(poll_periods({ "0;000a" }, 5) == periods{ 20ms, 40ms, 80ms, 160ms, 160ms });
+}
+
+TEST_CASE("adaptive_poller returns to the fastest period when the speed changes", "[adaptive_poller]") {
+    CHECK(poll_periods({ "1500;0004", "1500;0004", "1500;0004", "1497;0004", "1490;0004", "1490;0004" }, 6) ==
+          periods{ 20ms, 40ms, 80ms, 160ms, 20ms, 40ms });
+}
+
+TEST_CASE("adaptive_poller polls a transitioning pump at the fastest period", "[adaptive_poller]") {
+    // Ramping, between stopped and normal speed even while the speed holds
+    CHECK(poll_periods({ "800;0080" }, 3) == periods{ 20ms, 20ms, 20ms });
+
+    // Failed
+    CHECK(poll_periods({ "0;0003" }, 3) == periods{ 20ms, 20ms, 20ms });
+}
+
+TEST_CASE("adaptive_poller backs off a pump which does not answer", "[adaptive_poller]") {
+    CHECK(poll_periods({ "" }, 4) == periods{ 40ms, 80ms, 160ms, 160ms });
+
+    // and speeds up again once it does
+    CHECK(poll_periods({ "", "", "1500;0004" }, 4) == periods{ 40ms, 80ms, 20ms, 40ms });
+}
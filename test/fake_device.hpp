@@ -0,0 +1,177 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#ifndef EDWARDS_TEST_FAKE_DEVICE_HPP
+#define EDWARDS_TEST_FAKE_DEVICE_HPP
+
+#include <atomic>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <boost/asio/io_service.hpp>
+
+namespace edwards::test {
+    /// The reply a pump gives to request with data, e.g. "#01:00*V852 1350;0401\r" to "#01:00?V852\r".
+    inline auto reply_to(std::string_view request, std::string_view data) -> std::string {
+        auto reply = std::string{ "#" };
+        reply.append(request.substr(1, 5));
+        reply += '*';
+        reply.append(request.substr(7, 4));
+        reply += ' ';
+        reply.append(data);
+        reply += '\r';
+        return reply;
+    }
+
+    /// A pseudo-terminal standing in for the RS485 adapter, answering each request with whatever
+    /// its responder returns.  The device path is a symlink to the terminal, so the adapter can be
+    /// unplugged, failing every operation on the port and any attempt to reopen it, and plugged
+    /// back in as a new terminal.
+    class fake_device {
+    public:
+        /// Returns the bytes to send back for a request, nothing to stay silent.
+        using responder = std::function<std::string(std::string_view request)>;
+
+        explicit fake_device(responder respond = [](std::string_view request) { return reply_to(request, "0"); })
+            : _respond{ std::move(respond) }
+        {
+            char dir[] = "/tmp/edwards-test-XXXXXX";
+            _dir = ::mkdtemp(dir);
+            _path = _dir + "/tty";
+            plug();
+        }
+
+        ~fake_device() {
+            unplug();
+            ::rmdir(_dir.c_str());
+        }
+
+        fake_device(const fake_device &) = delete;
+        fake_device & operator=(const fake_device &) = delete;
+
+        auto path() const -> const std::string & {
+            return _path;
+        }
+
+        auto set_responder(responder respond) -> void {
+            auto lock = std::lock_guard{ _mutex };
+            _respond = std::move(respond);
+        }
+
+        /// Every request received so far, in order.
+        auto requests() const -> std::vector<std::string> {
+            auto lock = std::lock_guard{ _mutex };
+            return _requests;
+        }
+
+        auto plug() -> void {
+            if (_master >= 0) {
+                return;
+            }
+            ::openpty(&_master, &_slave, nullptr, nullptr, nullptr);
+
+            // The bus sets the same when it opens the port, but it must hold before then too
+            auto raw = termios{ };
+            ::tcgetattr(_slave, &raw);
+            ::cfmakeraw(&raw);
+            ::tcsetattr(_slave, TCSANOW, &raw);
+
+            ::symlink(::ttyname(_slave), _path.c_str());
+            _running = true;
+            _thread = std::thread{ [this] { serve(); } };
+        }
+
+        auto unplug() -> void {
+            if (_master < 0) {
+                return;
+            }
+            _running = false;
+            _thread.join();
+            ::unlink(_path.c_str());
+            ::close(_master);
+            ::close(_slave);
+            _master = _slave = -1;
+        }
+
+    private:
+        auto serve() -> void {
+            auto pending = std::string{ };
+            while (_running) {
+                auto fd = pollfd{ _master, POLLIN, 0 };
+                if (::poll(&fd, 1, 5) <= 0) {
+                    continue;
+                }
+
+                char buffer[128];
+                const auto n = ::read(_master, buffer, sizeof(buffer));
+                if (n <= 0) {
+                    continue;
+                }
+                pending.append(buffer, static_cast<std::size_t>(n));
+
+                for (auto end = pending.find('\r'); end != std::string::npos; end = pending.find('\r')) {
+                    const auto request = pending.substr(0, end + 1);
+                    pending.erase(0, end + 1);
+
+                    auto reply = std::string{ };
+                    {
+                        auto lock = std::lock_guard{ _mutex };
+                        _requests.push_back(request);
+                        reply = _respond(request);
+                    }
+                    if (!reply.empty()) {
+                        ::write(_master, reply.data(), reply.size());
+                    }
+                }
+            }
+        }
+
+        mutable std::mutex       _mutex;
+        responder                _respond;
+        std::vector<std::string> _requests;
+        std::string              _dir;
+        std::string              _path;
+        int                      _master = -1;
+        int                      _slave = -1;
+        std::atomic<bool>        _running{ false };
+        std::thread              _thread;
+    };
+
+    /// Runs an io_service on a thread of its own until destroyed, abandoning any handlers left.
+    class io_thread {
+    public:
+        explicit io_thread(boost::asio::io_service & service)
+            : _service{ service }
+            , _work{ service }
+            , _thread{ [&service] { service.run(); } }
+        { }
+
+        ~io_thread() {
+            _service.stop();
+            _thread.join();
+        }
+
+        io_thread(const io_thread &) = delete;
+        io_thread & operator=(const io_thread &) = delete;
+
+    private:
+        boost::asio::io_service &       _service;
+        boost::asio::io_service::work   _work;
+        std::thread                     _thread;
+    };
+} // namespace edwards::test
+
+#endif // EDWARDS_TEST_FAKE_DEVICE_HPP
@@ -0,0 +1,107 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/fleet_status.hpp>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <catch.hpp>
+
+using namespace edwards;
+
+namespace {
+    // Straightforward evaluation of the documented semantics, to check the vector kernels against
+    auto reference_matches(std::uint32_t status, const status_predicate & p) -> bool {
+        const auto all_of = static_cast<std::uint32_t>(p.all_of);
+        const auto any_of = static_cast<std::uint32_t>(p.any_of);
+        const auto none_of = static_cast<std::uint32_t>(p.none_of);
+        return (status & all_of) == all_of &&
+               (any_of == 0 || (status & any_of) != 0) &&
+               (status & none_of) == 0;
+    }
+
+    auto reference_scan(const std::vector<std::uint32_t> & current, const std::vector<std::uint32_t> & previous,
+                        const status_predicate & p, std::uint32_t watched) -> fleet_scan {
+        auto result = fleet_scan{ };
+        for (auto i = std::uint32_t{ 0 }; i < current.size(); ++i) {
+            if (reference_matches(current[i], p)) {
+                result.matches.push_back(i);
+            }
+            if ((current[i] & ~previous[i] & watched) != 0) {
+                result.raised.push_back(i);
+            }
+            if ((previous[i] & ~current[i] & watched) != 0) {
+                result.cleared.push_back(i);
+            }
+        }
+        return result;
+    }
+
+    // Statuses drawn from a few bits, so that predicates match a useful fraction of the fleet
+    auto random_status(std::mt19937 & rng) -> std::uint32_t {
+        auto status = std::uint32_t{ 0 };
+        for (const auto bit : { 0u, 1u, 4u, 10u, 15u, 31u }) {
+            if (rng() % 3 == 0) {
+                status |= 1u << bit;
+            }
+        }
+        return status;
+    }
+}
+
+TEST_CASE("fleet_status scans match a scalar reference", "[fleet_status]") {
+    auto rng = std::mt19937{ 852 };
+
+    // Sizes around the vector widths exercise the scalar tail as well as the kernels
+    for (const auto size : { 0u, 1u, 3u, 4u, 7u, 8u, 9u, 17u, 1003u }) {
+        auto fleet = fleet_status{ size };
+        auto current = std::vector<std::uint32_t>(size);
+        auto previous = std::vector<std::uint32_t>(size);
+        for (auto i = std::size_t{ 0 }; i < size; ++i) {
+            previous[i] = random_status(rng);
+            fleet.set(i, static_cast<nEXT_status>(previous[i]));
+        }
+        fleet.advance();
+        for (auto i = std::size_t{ 0 }; i < size; ++i) {
+            // Leave most pumps unchanged between snapshots
+            current[i] = rng() % 4 == 0 ? random_status(rng) : previous[i];
+            fleet.set(i, static_cast<nEXT_status>(current[i]));
+        }
+
+        for (auto round = 0; round < 50; ++round) {
+            const auto predicate = status_predicate{
+                static_cast<nEXT_status>(random_status(rng) & random_status(rng)),
+                static_cast<nEXT_status>(round % 2 == 0 ? 0 : random_status(rng)),
+                static_cast<nEXT_status>(random_status(rng) & random_status(rng))
+            };
+            const auto watched = round % 5 == 0 ? ~std::uint32_t{ 0 } : random_status(rng);
+
+            const auto expected = reference_scan(current, previous, predicate, watched);
+
+            auto actual = fleet_scan{ };
+            fleet.scan(predicate, static_cast<nEXT_status>(watched), actual);
+            CHECK(actual.matches == expected.matches);
+            CHECK(actual.raised == expected.raised);
+            CHECK(actual.cleared == expected.cleared);
+            CHECK(fleet.count(predicate) == expected.matches.size());
+        }
+    }
+}
+
+TEST_CASE("fleet_status scan appends to the result", "[fleet_status]") {
+    auto fleet = fleet_status{ 12 };
+    fleet.set(2, static_cast<nEXT_status>(1));
+    fleet.set(9, static_cast<nEXT_status>(1));
+
+    auto result = fleet_scan{ };
+    result.matches.push_back(100);
+    fleet.scan(status_predicate{ static_cast<nEXT_status>(1) }, static_cast<nEXT_status>(1), result);
+
+    CHECK(result.matches == std::vector<std::uint32_t>{ 100, 2, 9 });
+    CHECK(result.raised == std::vector<std::uint32_t>{ 2, 9 });
+    CHECK(result.cleared.empty());
+}
@@ -0,0 +1,81 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/internal/blocking_exchange.hpp>
+
+#include <chrono>
+#include <string_view>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <boost/asio/error.hpp>
+
+#include <catch.hpp>
+
+using namespace edwards;
+using namespace edwards::internal;
+using namespace std::chrono_literals;
+
+namespace {
+    /// Both ends of a socketpair, the port being the first and the device the second.
+    struct connected_pair {
+        connected_pair() {
+            REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        }
+
+        ~connected_pair() {
+            ::close(fds[0]);
+            ::close(fds[1]);
+        }
+
+        /// Sends bytes from the device to the port.
+        auto reply(std::string_view bytes) -> void {
+            REQUIRE(::write(fds[1], bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+        }
+
+        int fds[2];
+    };
+
+    auto make_message(std::string_view text) -> message_buffer {
+        auto message = message_buffer{ };
+        text.copy(message.data(), message.size());
+        return message;
+    }
+
+    auto exchange(connected_pair & pair, const message_buffer & message, message_buffer & response) -> error_code {
+        return exchange_on_port(pair.fds[0], message, response, std::chrono::steady_clock::now() + 200ms,
+                                std::chrono::microseconds{ 0 }, nullptr, 0);
+    }
+}
+
+TEST_CASE("exchange_on_port skips a foreign message read together with the reply", "[blocking_exchange]") {
+    auto pair = connected_pair{ };
+    const auto message = make_message("#01:00?V852\r");
+    auto response = message_buffer{ };
+
+    // Both arrive before the exchange starts reading, so a single read returns them
+    pair.reply("#02:00*V852 0;0000\r#01:00*V852 1350;0401\r");
+    CHECK(!exchange(pair, message, response));
+    CHECK(view_data(response) == "1350;0401");
+}
+
+TEST_CASE("exchange_on_port times out with only a foreign message", "[blocking_exchange]") {
+    auto pair = connected_pair{ };
+    const auto message = make_message("#01:00?V852\r");
+    auto response = message_buffer{ };
+
+    pair.reply("#02:00*V852 0;0000\r");
+    CHECK(exchange(pair, message, response) == boost::asio::error::timed_out);
+}
+
+TEST_CASE("exchange_on_port rejects a reply too short to parse", "[blocking_exchange]") {
+    auto pair = connected_pair{ };
+    const auto message = make_message("#01:00?V852\r");
+    auto response = message_buffer{ };
+
+    pair.reply("#01:00\r");
+    CHECK(exchange(pair, message, response) == boost::system::errc::protocol_error);
+}
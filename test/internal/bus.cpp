@@ -0,0 +1,212 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/internal/bus.hpp>
+#include <edwards/internal/dialog.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <optional>
+#include <thread>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <common/coroutines.hpp>
+
+#include <catch.hpp>
+
+#include "../fake_device.hpp"
+
+using namespace edwards;
+using namespace edwards::internal;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr auto never_retried = exchange_class{ idempotency::never, nullptr };
+
+    auto exchange(bus & b, request_options options, const char * message,
+                  exchange_class kind = never_retried) -> boost::future<dialog_result> {
+        co_return co_await dialog{ b, options, kind, message };
+    }
+
+    /// The outcome of a request, failing the test rather than hanging if it never completes.
+    auto outcome(boost::future<dialog_result> & request) -> dialog_result {
+        REQUIRE(request.wait_for(boost::chrono::seconds{ 5 }) == boost::future_status::ready);
+        return request.get();
+    }
+}
+
+TEST_CASE("bus holds queued dialogs until the port is reopened", "[bus]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    auto before = exchange(b, { }, "#01:00?V852\r");
+    CHECK(!outcome(before).ec);
+
+    // The first request after the adapter goes away fails, the port is reopened after that
+    device.unplug();
+    auto broken = exchange(b, { }, "#01:00?V852\r");
+    CHECK(outcome(broken).ec);
+
+    auto held = exchange(b, { }, "#02:00?V852\r");
+    std::this_thread::sleep_for(100ms);
+    CHECK(!held.is_ready());
+
+    device.plug();
+    CHECK(!outcome(held).ec);
+    const auto requests = device.requests();
+    REQUIRE(!requests.empty());
+    CHECK(requests.back() == "#02:00?V852\r");
+}
+
+TEST_CASE("bus fails a held dialog once its deadline passes", "[bus]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    device.unplug();
+    auto broken = exchange(b, { }, "#01:00?V852\r");
+    CHECK(outcome(broken).ec);
+
+    // Let the reconnect back-off grow to its longest, the deadline must still be kept to well
+    // within that
+    std::this_thread::sleep_for(1200ms);
+
+    const auto submitted = std::chrono::steady_clock::now();
+    auto late = exchange(b, within(50ms), "#02:00?V852\r");
+    const auto result = outcome(late);
+    const auto waited = std::chrono::steady_clock::now() - submitted;
+
+    CHECK(result.ec == boost::asio::error::timed_out);
+    CHECK(waited >= 50ms);
+    CHECK(waited < 250ms);
+}
+
+TEST_CASE("bus only plans retries of transient errors", "[bus][retry]") {
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(b.plan_retry(make_error_code(boost::system::errc::protocol_error), 1, std::nullopt));
+    CHECK(b.plan_retry(make_error_code(error::checksum_), 1, std::nullopt));
+    CHECK(b.plan_retry(error_code{ EIO, boost::system::system_category() }, 1, std::nullopt));
+
+    // Errors the pump reports are answers, repeating the request would get the same one
+    CHECK(!b.plan_retry(make_error_code(error::out_of_range), 1, std::nullopt));
+    CHECK(!b.plan_retry(make_error_code(boost::system::errc::operation_canceled), 1, std::nullopt));
+}
+
+TEST_CASE("bus stops retrying after max_attempts", "[bus][retry]") {
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+
+    auto policy = retry_policy{ };
+    policy.max_attempts = 3;
+    b.set_retry_policy(policy);
+
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 2, std::nullopt));
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 3, std::nullopt));
+}
+
+TEST_CASE("bus backs off by a random time up to the exponential ceiling", "[bus][retry]") {
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+
+    auto policy = retry_policy{ };
+    policy.max_attempts = 100;
+    policy.base_backoff = 20ms;
+    policy.max_backoff = 250ms;
+    policy.budget_cap = 10000;
+    b.set_retry_policy(policy);
+
+    const auto check_range = [&](int attempts, std::chrono::milliseconds ceiling) {
+        CAPTURE(attempts);
+        auto shortest = std::chrono::steady_clock::duration::max();
+        auto longest = std::chrono::steady_clock::duration::zero();
+        for (auto i = 0; i < 200; ++i) {
+            const auto backoff = b.plan_retry(boost::asio::error::timed_out, attempts, std::nullopt);
+            REQUIRE(backoff);
+            shortest = std::min(shortest, *backoff);
+            longest = std::max(longest, *backoff);
+        }
+        CHECK(shortest >= 0ms);
+        CHECK(longest <= ceiling);
+        // Spread over the range rather than fixed, so requests failing together spread out
+        CHECK(longest - shortest >= ceiling / 2);
+    };
+
+    check_range(1, 20ms);
+    check_range(2, 40ms);
+    check_range(3, 80ms);
+    check_range(10, 250ms);
+}
+
+TEST_CASE("bus does not plan a retry which would overrun the deadline", "[bus][retry]") {
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+
+    auto policy = retry_policy{ };
+    policy.budget_cap = 1;
+    b.set_retry_policy(policy);
+
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 1, std::chrono::steady_clock::now()));
+
+    // Refusing did not spend the only retry in the budget
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::chrono::steady_clock::now() + 1s));
+}
+
+TEST_CASE("bus bounds retries by a budget earned from successes", "[bus][retry]") {
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ };
+    auto b = bus{ service, device.path() };
+
+    auto policy = retry_policy{ };
+    policy.budget_ratio = 0.5;
+    policy.budget_cap = 2;
+    b.set_retry_policy(policy);
+
+    // The budget starts full
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+
+    // Two successes earn one retry
+    b.record_success();
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    b.record_success();
+    b.record_success();
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+
+    // Savings are capped
+    for (auto i = 0; i < 100; ++i) {
+        b.record_success();
+    }
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+    CHECK(!b.plan_retry(boost::asio::error::timed_out, 1, std::nullopt));
+}
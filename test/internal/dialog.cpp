@@ -3,3 +3,154 @@
 //    (See accompanying file LICENSE_1_0.txt or copy at
 //          http://www.boost.org/LICENSE_1_0.txt)
 
+#include <edwards/internal/dialog.hpp>
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_service.hpp>
+
+#include <common/coroutines.hpp>
+
+#include <catch.hpp>
+
+#include "../fake_device.hpp"
+
+using namespace edwards;
+using namespace edwards::internal;
+using namespace std::chrono_literals;
+
+namespace {
+    constexpr auto never_retried = exchange_class{ idempotency::never, nullptr };
+
+    auto exchange(bus & b, request_options options, const char * message) -> boost::future<dialog_result> {
+        co_return co_await dialog{ b, options, never_retried, message };
+    }
+
+    auto outcome(boost::future<dialog_result> & request) -> dialog_result {
+        REQUIRE(request.wait_for(boost::chrono::seconds{ 5 }) == boost::future_status::ready);
+        return request.get();
+    }
+
+    /// Pump 1 takes a while to answer, keeping the bus busy, pump 9 never answers and the rest
+    /// answer at once.
+    auto respond(std::string_view request) -> std::string {
+        if (request.substr(1, 2) == "01") {
+            std::this_thread::sleep_for(150ms);
+        }
+        else if (request.substr(1, 2) == "09") {
+            return { };
+        }
+        return test::reply_to(request, "0;0000");
+    }
+
+    auto was_sent(const test::fake_device & device, std::string_view request) -> bool {
+        for (const auto & r : device.requests()) {
+            if (r == request) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+TEST_CASE("dialog still queued at its deadline is dropped without being sent", "[dialog]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ respond };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    auto busy = exchange(b, { }, "#01:00?V852\r");
+    auto stale = exchange(b, within(50ms), "#02:00?V852\r");
+    auto fresh = exchange(b, within(1s), "#03:00?V852\r");
+
+    CHECK(!outcome(busy).ec);
+    CHECK(outcome(stale).ec == boost::asio::error::timed_out);
+    CHECK(!outcome(fresh).ec);
+    CHECK(!was_sent(device, "#02:00?V852\r"));
+}
+
+TEST_CASE("dialog cancelled while queued is dropped without being sent", "[dialog]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ respond };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    auto source = cancellation_source{ };
+    auto options = request_options{ };
+    options.cancellation = source;
+
+    auto busy = exchange(b, { }, "#01:00?V852\r");
+    auto cancelled = exchange(b, options, "#02:00?V852\r");
+    source.cancel();
+
+    CHECK(!outcome(busy).ec);
+    CHECK(outcome(cancelled).ec == boost::system::errc::operation_canceled);
+    CHECK(!was_sent(device, "#02:00?V852\r"));
+}
+
+TEST_CASE("dialog exchanging at its deadline is abandoned", "[dialog]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ respond };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    const auto submitted = std::chrono::steady_clock::now();
+    auto silent = exchange(b, within(100ms), "#09:00?V852\r");
+    CHECK(outcome(silent).ec == boost::asio::error::timed_out);
+    CHECK(std::chrono::steady_clock::now() - submitted < response_timeout);
+
+    // The port is left usable
+    auto next = exchange(b, { }, "#03:00?V852\r");
+    CHECK(!outcome(next).ec);
+}
+
+TEST_CASE("dialog cancelled while exchanging is abandoned", "[dialog]") {
+    const auto dedicated = GENERATE(false, true);
+    CAPTURE(dedicated);
+
+    auto service = boost::asio::io_service{ };
+    auto device = test::fake_device{ respond };
+    auto b = bus{ service, device.path() };
+    if (dedicated) {
+        REQUIRE(!b.run_on_dedicated_thread(dedicated_thread_options{ }));
+    }
+    const auto runner = test::io_thread{ service };
+
+    auto source = cancellation_source{ };
+    auto options = request_options{ };
+    options.cancellation = source;
+
+    const auto submitted = std::chrono::steady_clock::now();
+    auto silent = exchange(b, options, "#09:00?V852\r");
+    std::this_thread::sleep_for(50ms);
+    REQUIRE(was_sent(device, "#09:00?V852\r"));
+    source.cancel();
+
+    CHECK(outcome(silent).ec == boost::system::errc::operation_canceled);
+    CHECK(std::chrono::steady_clock::now() - submitted < response_timeout);
+
+    auto next = exchange(b, { }, "#03:00?V852\r");
+    CHECK(!outcome(next).ec);
+}
@@ -0,0 +1,82 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/internal/mpsc_queue.hpp>
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+
+using namespace edwards::internal;
+
+namespace {
+    struct item : mpsc_node {
+        std::size_t producer = 0;
+        std::size_t sequence = 0;
+    };
+}
+
+TEST_CASE("mpsc_queue pops in push order", "[mpsc_queue]") {
+    auto queue = mpsc_queue<item>{ };
+    CHECK(queue.try_pop() == nullptr);
+
+    auto items = std::vector<item>(5);
+    for (auto & i : items) {
+        queue.push(i);
+    }
+    for (auto & i : items) {
+        CHECK(queue.try_pop() == &i);
+    }
+    CHECK(queue.try_pop() == nullptr);
+
+    // The stub is reused once the queue has drained
+    queue.push(items[0]);
+    CHECK(queue.try_pop() == &items[0]);
+    CHECK(queue.try_pop() == nullptr);
+}
+
+TEST_CASE("mpsc_queue keeps each producer's order under concurrent pushes", "[mpsc_queue]") {
+    constexpr auto producers = std::size_t{ 4 };
+    constexpr auto per_producer = std::size_t{ 20000 };
+
+    auto items = std::vector<std::vector<item>>(producers);
+    for (auto & v : items) {
+        v = std::vector<item>(per_producer);
+    }
+    auto queue = mpsc_queue<item>{ };
+
+    auto threads = std::vector<std::thread>{ };
+    for (auto p = std::size_t{ 0 }; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (auto s = std::size_t{ 0 }; s < per_producer; ++s) {
+                items[p][s].producer = p;
+                items[p][s].sequence = s;
+                queue.push(items[p][s]);
+            }
+        });
+    }
+
+    // Consume while the producers are still pushing
+    auto next = std::vector<std::size_t>(producers, 0);
+    auto popped = std::size_t{ 0 };
+    auto out_of_order = std::size_t{ 0 };
+    while (popped < producers * per_producer) {
+        if (const auto i = queue.try_pop()) {
+            if (i->sequence != next[i->producer]) {
+                ++out_of_order;
+            }
+            next[i->producer] = i->sequence + 1;
+            ++popped;
+        }
+    }
+    for (auto & t : threads) {
+        t.join();
+    }
+
+    CHECK(out_of_order == 0);
+    CHECK(queue.try_pop() == nullptr);
+}
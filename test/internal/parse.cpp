@@ -0,0 +1,95 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/internal/parse.hpp>
+
+#include <chrono>
+#include <tuple>
+
+#include <catch.hpp>
+
+using namespace edwards;
+using namespace edwards::internal;
+
+namespace {
+    const auto protocol_error = make_error_code(EDWARDS_ERROR_NS::errc::protocol_error);
+}
+
+TEST_CASE("parse_pump_info", "[parse]") {
+    const auto info = parse_pump_info("EXT75DX;D3960000A ;1500");
+    REQUIRE(info);
+    CHECK(info->type == "EXT75DX");
+    CHECK(info->DSP_version == "D3960000A ");
+    CHECK(units::unit_cast<int>(info->max_speed) == 1500);
+
+    CHECK(parse_pump_info("EXT75DX;D3960000A ").error() == protocol_error);
+    CHECK(parse_pump_info("EXT75DX D3960000A ;1500").error() == protocol_error);
+}
+
+TEST_CASE("parse_speed_status", "[parse]") {
+    const auto s = parse_speed_status("1350;0401");
+    REQUIRE(s);
+    CHECK(units::unit_cast<int>(s->speed) == 1350);
+    CHECK(s->status == static_cast<nEXT_status>(0x0401));
+
+    CHECK(parse_speed_status("").error() == protocol_error);
+    CHECK(parse_speed_status("1350").error() == protocol_error);
+}
+
+TEST_CASE("parse_vent_mode", "[parse]") {
+    CHECK(*parse_vent_mode("0") == static_cast<vent_mode>(0));
+    CHECK(*parse_vent_mode("6") == static_cast<vent_mode>(6));
+
+    CHECK(parse_vent_mode("").error() == protocol_error);
+    CHECK(parse_vent_mode("12").error() == protocol_error);
+    CHECK(parse_vent_mode("x").error() == protocol_error);
+}
+
+TEST_CASE("parse_integer", "[parse]") {
+    CHECK(*parse_integer("0") == 0);
+    CHECK(*parse_integer("240") == 240);
+
+    CHECK(parse_integer("").error() == protocol_error);
+    CHECK(parse_integer("-1").error() == protocol_error);
+    CHECK(parse_integer(";1").error() == protocol_error);
+}
+
+TEST_CASE("parse_temperature", "[parse]") {
+    const auto t = parse_temperature("41;-3");
+    REQUIRE(t);
+    CHECK(units::unit_cast<int>(t->motor) == 41);
+    CHECK(units::unit_cast<int>(t->controller) == -3);
+
+    CHECK(parse_temperature("").error() == protocol_error);
+    CHECK(parse_temperature("41").error() == protocol_error);
+}
+
+TEST_CASE("parse_PIC_version", "[parse]") {
+    CHECK(*parse_PIC_version("D39618000A") == "D39618000A");
+
+    CHECK(parse_PIC_version("").error() == protocol_error);
+    CHECK(parse_PIC_version("D3961;8000A").error() == protocol_error);
+    CHECK(parse_PIC_version("D39618\x01").error() == protocol_error);
+}
+
+TEST_CASE("parse_run_hours", "[parse]") {
+    const auto hours = parse_run_hours("12345;678");
+    REQUIRE(hours);
+    CHECK(std::get<0>(*hours) == std::chrono::hours{ 12345 });
+    CHECK(std::get<1>(*hours) == std::chrono::hours{ 678 });
+
+    CHECK(parse_run_hours("").error() == protocol_error);
+    CHECK(parse_run_hours("12345").error() == protocol_error);
+    CHECK(parse_run_hours(";678").error() == protocol_error);
+}
+
+TEST_CASE("parse_service_status", "[parse]") {
+    CHECK(*parse_service_status("0") == static_cast<service_status>(0));
+    CHECK(*parse_service_status("5") == static_cast<service_status>(5));
+    CHECK(*parse_service_status("a") == static_cast<service_status>(0xa));
+
+    CHECK(parse_service_status("").error() == protocol_error);
+    CHECK(parse_service_status(";").error() == protocol_error);
+}
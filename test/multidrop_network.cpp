@@ -0,0 +1,113 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/multidrop_network.hpp>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+
+#include <boost/asio/io_service.hpp>
+
+#include <catch.hpp>
+
+#include "fake_device.hpp"
+
+using namespace edwards;
+
+namespace {
+    /// The reply of a pump rejecting request with code.
+    auto error_reply(std::string_view request, int code) -> std::string {
+        auto reply = std::string{ "#" };
+        reply.append(request.substr(1, 5));
+        reply += '=';
+        reply.append(request.substr(7, 4));
+        reply += ' ';
+        reply += std::to_string(code);
+        reply += '\r';
+        return reply;
+    }
+
+    template<typename T>
+    auto outcome(boost::future<T> & request) -> T {
+        REQUIRE(request.wait_for(boost::chrono::seconds{ 5 }) == boost::future_status::ready);
+        return request.get();
+    }
+
+    // Which requests a fake device received, without the address and terminator, e.g. "?V852"
+    auto objects(const test::fake_device & device) -> std::vector<std::string> {
+        auto result = std::vector<std::string>{ };
+        for (const auto & r : device.requests()) {
+            result.push_back(r.substr(6, r.size() - 7));
+        }
+        return result;
+    }
+}
+
+TEST_CASE("multidrop_network repeats a query whose reply is garbled", "[multidrop_network][retry]") {
+    auto first = std::atomic<bool>{ true };
+    auto device = test::fake_device{ [&](std::string_view request) {
+        return test::reply_to(request, first.exchange(false) ? "1350" : "1350;0014");
+    } };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+    const auto runner = test::io_thread{ service };
+
+    auto status = network.try_pump_speed_status(multidrop_endpoint{ 1 });
+    const auto r = outcome(status);
+    REQUIRE(r);
+    CHECK(units::unit_cast<int>(r->speed) == 1350);
+    CHECK(objects(device) == std::vector<std::string>{ "?V852", "?V852" });
+}
+
+TEST_CASE("multidrop_network repeats a setter which was not answered", "[multidrop_network][retry]") {
+    auto first = std::atomic<bool>{ true };
+    auto device = test::fake_device{ [&](std::string_view request) {
+        return first.exchange(false) ? std::string{ } : test::reply_to(request, "0");
+    } };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+    const auto runner = test::io_thread{ service };
+
+    auto set = network.try_pump_timer(multidrop_endpoint{ 1 }, std::chrono::minutes{ 8 });
+    CHECK(outcome(set));
+    CHECK(objects(device) == std::vector<std::string>{ "!S854 8", "!S854 8" });
+}
+
+TEST_CASE("multidrop_network reads back a start command before repeating it", "[multidrop_network][retry]") {
+    // The pump acts on the command but the reply is lost
+    auto first = std::atomic<bool>{ true };
+    auto device = test::fake_device{ [&](std::string_view request) {
+        if (first.exchange(false)) {
+            return std::string{ };
+        }
+        return test::reply_to(request, "0;0010");
+    } };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+    const auto runner = test::io_thread{ service };
+
+    auto start = network.try_start_pump(multidrop_endpoint{ 1 });
+    CHECK(outcome(start));
+    CHECK(objects(device) == std::vector<std::string>{ "!C852 1", "?V852" });
+}
+
+TEST_CASE("multidrop_network does not repeat a request the pump rejected", "[multidrop_network][retry]") {
+    auto device = test::fake_device{ [](std::string_view request) { return error_reply(request, 4); } };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+    const auto runner = test::io_thread{ service };
+
+    auto query = network.try_pump_speed_status(multidrop_endpoint{ 1 });
+    CHECK(outcome(query).error() == make_error_code(error::out_of_range));
+
+    auto set = network.try_pump_timer(multidrop_endpoint{ 1 }, std::chrono::minutes{ 8 });
+    CHECK(outcome(set).error() == make_error_code(error::out_of_range));
+
+    auto start = network.try_start_pump(multidrop_endpoint{ 1 });
+    CHECK(outcome(start).error() == make_error_code(error::out_of_range));
+
+    CHECK(objects(device) == std::vector<std::string>{ "?V852", "!S854 8", "!C852 1" });
+}
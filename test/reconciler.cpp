@@ -0,0 +1,87 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/reconciler.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <catch.hpp>
+
+#include "fake_device.hpp"
+
+using namespace edwards;
+using namespace std::chrono_literals;
+
+namespace {
+    /// A pump whose timer is set to 8 minutes.
+    auto respond(std::string_view request) -> std::string {
+        return test::reply_to(request, "8");
+    }
+
+    auto timer_reads(const test::fake_device & device) -> std::size_t {
+        const auto requests = device.requests();
+        return static_cast<std::size_t>(std::count(requests.begin(), requests.end(), "#01:00?S854\r"));
+    }
+}
+
+TEST_CASE("configuration_reconciler reports drift on every periodic check", "[reconciler]") {
+    auto device = test::fake_device{ respond };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+
+    auto reconciler = configuration_reconciler{ network };
+    auto settings = pump_settings{ };
+    settings.timer = 10min;
+    reconciler.set_target(multidrop_endpoint{ 1 }, settings);
+
+    auto reports = std::vector<reconcile_report>{ };
+    reconciler.start_drift_checks(20ms, [&](const reconcile_report & report) {
+        reports.push_back(report);
+        if (reports.size() == 3) {
+            reconciler.stop_drift_checks();
+        }
+    });
+    service.run();
+
+    REQUIRE(reports.size() == 3);
+    for (const auto & report : reports) {
+        REQUIRE(report.changes.size() == 1);
+        CHECK(report.changes[0].setting == pump_setting::timer);
+        CHECK(report.changes[0].status == reconcile_status::drifted);
+        CHECK(report.in_sync == 0);
+    }
+
+    // Nothing was written
+    CHECK(timer_reads(device) == 3);
+    CHECK(device.requests().size() == 3);
+}
+
+TEST_CASE("configuration_reconciler keeps checking quietly while in sync", "[reconciler]") {
+    auto device = test::fake_device{ respond };
+    auto service = boost::asio::io_service{ };
+    auto network = multidrop_network{ service, device.path() };
+
+    auto reconciler = configuration_reconciler{ network };
+    auto settings = pump_settings{ };
+    settings.timer = 8min;
+    reconciler.set_target(multidrop_endpoint{ 1 }, settings);
+
+    auto drifted = 0;
+    reconciler.start_drift_checks(20ms, [&](const reconcile_report &) { ++drifted; });
+
+    auto stop = boost::asio::steady_timer{ service, 150ms };
+    stop.async_wait([&](const error_code &) { reconciler.stop_drift_checks(); });
+    service.run();
+
+    CHECK(drifted == 0);
+    CHECK(timer_reads(device) >= 3);
+}
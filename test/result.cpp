@@ -0,0 +1,69 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/result.hpp>
+
+#include <memory>
+#include <string>
+
+#include <catch.hpp>
+
+using namespace edwards;
+
+namespace {
+    const auto failure = make_error_code(EDWARDS_ERROR_NS::errc::timed_out);
+}
+
+TEST_CASE("result holds a value", "[result]") {
+    auto r = result<std::string>{ std::string{ "V852" } };
+
+    CHECK(r.has_value());
+    CHECK(static_cast<bool>(r));
+    CHECK(!r.error());
+    CHECK(*r == "V852");
+    CHECK(r->size() == 4);
+    CHECK(r.value() == "V852");
+    CHECK(r.value_or("none") == "V852");
+
+    r.value() += "0";
+    CHECK(*r == "V8520");
+}
+
+TEST_CASE("result holds an error", "[result]") {
+    const auto r = result<int>{ failure };
+
+    CHECK(!r.has_value());
+    CHECK(!r);
+    CHECK(r.error() == failure);
+    CHECK(r.value_or(7) == 7);
+    CHECK_THROWS_AS(r.value(), EDWARDS_ERROR_NS::system_error);
+
+    try {
+        r.value();
+    }
+    catch (const EDWARDS_ERROR_NS::system_error & e) {
+        CHECK(e.code() == failure);
+    }
+}
+
+TEST_CASE("result moves its value out", "[result]") {
+    auto r = result<std::unique_ptr<int>>{ std::make_unique<int>(3) };
+
+    const auto value = std::move(r).value();
+    REQUIRE(value);
+    CHECK(*value == 3);
+}
+
+TEST_CASE("result<void> holds success or an error", "[result]") {
+    const auto ok = result<void>{ };
+    CHECK(ok.has_value());
+    CHECK(!ok.error());
+    CHECK_NOTHROW(ok.value());
+
+    const auto failed = result<void>{ failure };
+    CHECK(!failed);
+    CHECK(failed.error() == failure);
+    CHECK_THROWS_AS(failed.value(), EDWARDS_ERROR_NS::system_error);
+}
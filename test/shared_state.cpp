@@ -0,0 +1,115 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/shared_state.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/system/system_error.hpp>
+
+#include <catch.hpp>
+
+using namespace edwards;
+
+namespace {
+    /// Shared memory object removed again at the end of the test.
+    struct temporary_segment {
+        temporary_segment()
+            : name{ "/edwards-test-" + std::to_string(::getpid()) }
+        { }
+
+        ~temporary_segment() {
+            state_publisher::remove(name);
+        }
+
+        std::string name;
+    };
+}
+
+TEST_CASE("state_reader sees what state_publisher published", "[shared_state]") {
+    const auto segment = temporary_segment{ };
+    auto publisher = state_publisher{ segment.name };
+    const auto reader = state_reader{ segment.name };
+
+    CHECK(!reader.read(multidrop_endpoint{ 5 }));
+
+    const auto before = std::chrono::system_clock::now();
+    publisher.publish_status(multidrop_endpoint{ 5 }, hertz_t{ 1500.0 }, static_cast<nEXT_status>(0x0401));
+
+    const auto status = reader.read(multidrop_endpoint{ 5 });
+    REQUIRE(status);
+    CHECK(units::unit_cast<int>(status->speed) == 1500);
+    CHECK(status->status == static_cast<nEXT_status>(0x0401));
+    CHECK(status->status_time >= before - std::chrono::seconds{ 1 });
+    CHECK(status->temperature_time == std::chrono::system_clock::time_point{ });
+
+    publisher.publish_temperature(multidrop_endpoint{ 5 }, pump_temperature{ celsius_t{ 41.0 }, celsius_t{ -3.0 } });
+
+    const auto both = reader.read(multidrop_endpoint{ 5 });
+    REQUIRE(both);
+    CHECK(units::unit_cast<int>(both->speed) == 1500);
+    CHECK(units::unit_cast<int>(both->temperature.motor) == 41);
+    CHECK(units::unit_cast<int>(both->temperature.controller) == -3);
+    CHECK(both->temperature_time >= status->status_time);
+
+    // Other pumps are untouched
+    CHECK(!reader.read(multidrop_endpoint{ 6 }));
+}
+
+TEST_CASE("state_reader rejects a missing segment", "[shared_state]") {
+    const auto segment = temporary_segment{ };
+    CHECK_THROWS_AS(state_reader{ segment.name }, boost::system::system_error);
+}
+
+TEST_CASE("state_reader never sees a torn update", "[shared_state]") {
+    const auto segment = temporary_segment{ };
+    auto publisher = state_publisher{ segment.name };
+    const auto reader = state_reader{ segment.name };
+    const auto pump = multidrop_endpoint{ 7 };
+
+    // Every update writes the same value to both fields of a group, so a snapshot taken while a
+    // write was part done would show them differing.  Two writers share the slot to check they
+    // take turns.
+    auto stop = std::atomic<bool>{ false };
+    auto writers = std::vector<std::thread>{ };
+    for (auto w = 0; w < 2; ++w) {
+        writers.emplace_back([&, w] {
+            for (auto i = std::uint32_t{ 1 }; !stop.load(std::memory_order_relaxed); ++i) {
+                const auto value = (i * 2 + static_cast<std::uint32_t>(w)) % 30000;
+                publisher.publish_status(pump, hertz_t{ static_cast<double>(value) }, static_cast<nEXT_status>(value));
+                const auto t = celsius_t{ static_cast<double>(value % 200) };
+                publisher.publish_temperature(pump, pump_temperature{ t, t });
+            }
+        });
+    }
+
+    auto snapshots = 0;
+    auto torn = 0;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds{ 200 };
+    while (std::chrono::steady_clock::now() < until) {
+        if (const auto s = reader.read(pump)) {
+            ++snapshots;
+            if (units::unit_cast<std::uint32_t>(s->speed) != static_cast<std::uint32_t>(s->status) ||
+                units::unit_cast<int>(s->temperature.motor) != units::unit_cast<int>(s->temperature.controller)) {
+                ++torn;
+            }
+        }
+    }
+
+    stop = true;
+    for (auto & w : writers) {
+        w.join();
+    }
+
+    CHECK(snapshots > 0);
+    CHECK(torn == 0);
+}
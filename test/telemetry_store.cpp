@@ -0,0 +1,120 @@
+//          Copyright Thomas A Myles 2017.
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <edwards/telemetry_store.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/system/system_error.hpp>
+
+#include <catch.hpp>
+
+using namespace edwards;
+using namespace std::chrono;
+
+namespace {
+    const auto epoch = system_clock::time_point{ hours{ 24 * 365 * 47 } };
+
+    // Steady one second polls with occasional jitter, gaps, status changes and sign changes in
+    // every delta, so that each column sees zero runs as well as large and negative values.
+    auto make_samples(std::size_t count) -> std::vector<telemetry_sample> {
+        auto samples = std::vector<telemetry_sample>{};
+        auto time = epoch;
+        for (auto i = std::size_t{ 0 }; i < count; ++i) {
+            time += seconds{ i % 97 == 0 ? 60 : 1 } + seconds{ i % 13 == 0 ? 1 : 0 };
+            samples.push_back(telemetry_sample{
+                time,
+                i % 200 < 100 ? std::uint32_t{ 1500 } : static_cast<std::uint32_t>(i * 7919 % 1600),
+                static_cast<nEXT_status>(i % 50 < 25 ? 0x0401u : 0x80000000u | static_cast<std::uint32_t>(i)),
+                static_cast<std::int16_t>(i % 7 == 0 ? -40 : 35),
+                static_cast<std::int16_t>(i % 300)
+            });
+        }
+        return samples;
+    }
+
+    auto check_series(const telemetry_series & series, const std::vector<telemetry_sample> & samples) -> void {
+        REQUIRE(series.size() == samples.size());
+        for (auto i = std::size_t{ 0 }; i < samples.size(); ++i) {
+            CHECK(series.time[i] == samples[i].time);
+            CHECK(series.speed[i] == samples[i].speed);
+            CHECK(series.status[i] == samples[i].status);
+            CHECK(series.motor_temperature[i] == samples[i].motor_temperature);
+            CHECK(series.controller_temperature[i] == samples[i].controller_temperature);
+        }
+    }
+
+    struct temporary_directory {
+        temporary_directory() {
+            char name[] = "/tmp/edwards-telemetry-XXXXXX";
+            REQUIRE(::mkdtemp(name) != nullptr);
+            path = name;
+        }
+
+        ~temporary_directory() {
+            std::system(("rm -rf '" + path + "'").c_str());
+        }
+
+        std::string path;
+    };
+}
+
+TEST_CASE("telemetry_store round-trips samples through the codec", "[telemetry_store]") {
+    const auto samples = make_samples(2000);
+
+    auto store = telemetry_store{};
+    for (const auto & s : samples) {
+        store.append(multidrop_endpoint{ 3 }, s);
+    }
+
+    // Every full chunk was compressed, the rest is still in the head
+    CHECK(store.compressed_size() > 0);
+    check_series(store.query(multidrop_endpoint{ 3 }, epoch, samples.back().time + seconds{ 1 }), samples);
+    CHECK(store.query(multidrop_endpoint{ 4 }, epoch, samples.back().time + seconds{ 1 }).size() == 0);
+}
+
+TEST_CASE("telemetry_store queries part of the history", "[telemetry_store]") {
+    const auto samples = make_samples(1500);
+
+    auto store = telemetry_store{};
+    for (const auto & s : samples) {
+        store.append(multidrop_endpoint{ 1 }, s);
+    }
+
+    const auto series = store.query(multidrop_endpoint{ 1 }, samples[600].time, samples[1100].time);
+    check_series(series, std::vector<telemetry_sample>(samples.begin() + 600, samples.begin() + 1100));
+}
+
+TEST_CASE("telemetry_store keeps file-backed history across restarts", "[telemetry_store]") {
+    const auto samples = make_samples(1200);
+    const auto dir = temporary_directory{};
+
+    auto opts = telemetry_store::options{};
+    opts.segment_size = 64 * 1024;
+    opts.directory = dir.path;
+    {
+        auto store = telemetry_store{ opts };
+        for (auto i = std::size_t{ 0 }; i < 700; ++i) {
+            store.append(multidrop_endpoint{ 2 }, samples[i]);
+        }
+
+        // A second store may not share the directory
+        CHECK_THROWS_AS(telemetry_store{ opts }, boost::system::system_error);
+    }
+    {
+        auto store = telemetry_store{ opts };
+        for (auto i = std::size_t{ 700 }; i < samples.size(); ++i) {
+            store.append(multidrop_endpoint{ 2 }, samples[i]);
+        }
+    }
+
+    auto store = telemetry_store{ opts };
+    check_series(store.query(multidrop_endpoint{ 2 }, epoch, samples.back().time + seconds{ 1 }), samples);
+}